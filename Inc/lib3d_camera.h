@@ -4,11 +4,10 @@
 #include "lib3d_config.h"
 #include "lib3d_math.h"
 
-// May be implemented in the future
-// typedef enum l3d_camera_type_ {
-//     L3D_CAMERA_TYPE_FIRST_PERSON,
-//     L3D_CAMERA_TYPE_CAROUSEL
-// } l3d_camera_type_t;
+typedef enum l3d_camera_type_ {
+    L3D_CAMERA_TYPE_PERSPECTIVE,
+    L3D_CAMERA_TYPE_ORTHOGRAPHIC	// parallel projection, no perspective divide
+} l3d_camera_type_t;
 
 typedef struct {
 	// Object properties:
@@ -34,10 +33,11 @@ typedef struct {
 	l3d_vec4_t local_up_dir;
 
 	l3d_rtnl_t fov;
+	l3d_rtnl_t ortho_height;	// height of the view volume of orthographic cameras, in world units
 	l3d_rtnl_t near_plane;
 	l3d_rtnl_t far_plane;
 
-	// l3d_camera_type_t type;	// may be implemented in the future
+	l3d_camera_type_t type;
 
 	bool has_moved;	// see description in the obj3d struct
 	bool is_modified;
@@ -50,7 +50,9 @@ typedef struct {
 l3d_err_t l3d_cam_reset(l3d_camera_t *cam);
 
 // l3d_rtnl_t l3d_cam_getFov(l3d_camera_t *cam);
+l3d_err_t l3d_cam_setType(l3d_camera_t *cam, l3d_camera_type_t type);
 l3d_err_t l3d_cam_setFov(l3d_camera_t *cam, l3d_rtnl_t fov);
+l3d_err_t l3d_cam_setOrthoHeight(l3d_camera_t *cam, l3d_rtnl_t height);
 l3d_err_t l3d_cam_setNearPlane(l3d_camera_t *cam, l3d_rtnl_t near_plane);
 l3d_err_t l3d_cam_setFarPlane(l3d_camera_t *cam, l3d_rtnl_t far_plane);
 
@@ -21,19 +21,36 @@
 // 
 
 #define L3D_CAMERA_MOVABLE				// Camera control defined below in this file
-// #define USE_FILLED_MESHES
+// #define USE_FILLED_MESHES		// Fill triangles of meshes with fill_colour, see l3d_drawSpanCallback();
+								// without depth sorting, so only correct for convex objects not overlapping on the screen
 // #define USE_LOADING_FROM_OBJ
 // #define L3D_RENDER_VISIBLE_ONLY		// Render only visible edges / faces
-// #define REMOVE_HIDDEN_LINES
+// #define REMOVE_HIDDEN_LINES		// Depth-test edges against a 16-bit depth buffer of all triangles
+// #define REMOVE_HIDDEN_LINES_ANALYTIC	// Split edges into visible parts by testing them against triangles, without a buffer
 // #define DRAW_CONTOUR_ONLY	// Draw only outlines of meshes
-// #define L3D_USE_SCREEN_CLIPPING  // may be implemented in the future, but it's not a priority
+#define L3D_USE_SCREEN_CLIPPING	// Clip edges to the screen rectangle before passing them to l3d_drawLineCallback()
 #define L3D_DRAW_INNER_EDGES
+// #define L3D_USE_FUSED_MVP		// Project model data with a single world*view*projection matrix per object
+#define L3D_USE_FRUSTUM_CULLING	// Skip objects whose bounding sphere lies outside the view frustum
+// #define L3D_USE_FRAMEBUFFER		// Render into the built-in framebuffer instead of calling l3d_drawLineCallback()
+// #define L3D_USE_LINE_BATCHING	// Pass lines in batches to l3d_drawLinesCallback(), see l3d_setLineBuffer()
+// #define L3D_USE_DIRTY_RECTANGLES	// Track screen regions changed by l3d_processScene(), see l3d_scene_getDirtyRects()
+// #define L3D_USE_SIMD		// Transform vertex arrays with SSE4.1 / AVX2 kernels on x86 hosts, chosen at run time
+// #define L3D_USE_SOA_VERTICES	// Store world vertices as x, y, z streams and projected vertices as int16_t screen x, y streams;
+								// not available with REMOVE_HIDDEN_LINES(_ANALYTIC) and L3D_USE_FUSED_MVP,
+								// which need the depth of projected vertices or skip world space
+// #define L3D_USE_SOA_OBJECTS	// Store object meshes, poses, flags, colours and gizmos in separate arrays indexed by object id
+								// instead of an array of l3d_obj3d_t, see L3D_OBJ_MESH() etc. in lib3d_scene.h
 
 // 
 // Display:
 // 
 #define SCREEN_WIDTH 800
 #define SCREEN_HEIGHT 400
+#define L3D_FRAMEBUFFER_CLEAR_COLOUR L3D_COLOUR_BLACK	// Used only with L3D_USE_FRAMEBUFFER
+#define L3D_DEPTH_BIAS 32	// Used only with REMOVE_HIDDEN_LINES(_ANALYTIC); how far (in 1/65536 of the depth range)
+							// an edge may lie behind a triangle and still be drawn
+#define L3D_HLR_MAX_HIDDEN_RANGES 16	// Used only with REMOVE_HIDDEN_LINES_ANALYTIC; per edge
 // #define COLOUR_MONOCHROME
 
 #ifndef COLOUR_MONOCHROME
@@ -116,6 +133,37 @@
 // Math:
 // 
 #define L3D_USE_FIXED_POINT_ARITHMETIC
+// #define L3D_USE_INTEGER_ONLY	// No floating point at run time, for MCUs without an FPU;
+								// link with Src/lib3d_integer_only.ld to check that no soft-float routines are pulled in
+// #define L3D_USE_GENERATED_FP_FORMAT	// Take L3D_FP_DP (fractional bits of fixed point numbers, 16 otherwise) from lib3d_fp_format.h,
+										// written by the model parser from the range of the scene (FixedPointBinaryDigits = auto)
+// #define L3D_COUNT_FIXED_POINT_OVERFLOWS	// Saturate l3d_fixedMul(), l3d_fixedDiv() and the perspective divide on overflow
+											// and count it, see l3d_getFixedPointOverflowCount(); turns off the L3D_USE_SIMD kernels
+
+
+// Fixed point trigonometry and square root, used with L3D_USE_FIXED_POINT_ARITHMETIC:
+#define L3D_SIN_LUT_BITS 8	// Quarter-wave sine table with linear interpolation, 2^bits entries:
+							// 8 - 512 B, error below 2/65536; 6 - 128 B, error below 6/65536;
+							// 0 - no table, Taylor polynomial (slower, error below 1/65536)
+#define L3D_CORDIC_ITERATIONS 18	// atan2() / asin() precision, about one bit per iteration (1..24)
+#define L3D_RSQRT_ITERATIONS 2	// Newton steps of 1 / sqrt() used by the normalise functions;
+								// each one doubles the correct bits, 2 are enough for 16 fractional bits
+#define L3D_USE_RECIPROCAL_DIVIDE	// Perspective divide with one reciprocal of w per vertex (64 entry seed table
+									// and Newton steps) and three multiplications instead of three 64 bit divisions
+#define L3D_RECIPROCAL_ITERATIONS 1	// Newton steps of the reciprocal: 1 - relative error below 2^-13 (8/65536 on screen);
+									// 2 - within 1/2 LSB of the exact quotient
+// #define L3D_USE_QUANTISED_VERTICES	// Model vertices as int16_t with a per mesh offset and shift (QuantiseVertices = True
+										// in the model parser config); world transform with Q1.14 rotation and 32 bit accumulators
+
+#if defined(L3D_USE_INTEGER_ONLY) && !defined(L3D_USE_FIXED_POINT_ARITHMETIC)
+#error "L3D_USE_INTEGER_ONLY needs L3D_USE_FIXED_POINT_ARITHMETIC"
+#endif
+#if defined(L3D_USE_QUANTISED_VERTICES) && !defined(L3D_USE_FIXED_POINT_ARITHMETIC)
+#error "L3D_USE_QUANTISED_VERTICES needs L3D_USE_FIXED_POINT_ARITHMETIC"
+#endif
+#ifdef L3D_USE_GENERATED_FP_FORMAT
+#include "lib3d_fp_format.h"
+#endif
 
 #include <stdbool.h> // c23 has some cool features - take a look
 
@@ -141,6 +189,16 @@
 // #define L3D_SCENE_VERTS_CAP 2048
 // #define L3D_SCENE_FACES_CAP 2048
 // #define L3D_SCENE_EDGES_CAP 2048
+#define L3D_SCENE_DIRTY_RECTS_CAP 8	// Used only with L3D_USE_DIRTY_RECTANGLES
+// #define L3D_USE_32BIT_INDICES	// Vertex, face and edge indices, counts and offsets as uint32_t instead of uint16_t,
+								// for scenes of more than 65535 transformed vertices (or model data entries);
+								// the model parser writes FaceArrayType / EdgeArrayType = l3d_index_t arrays
+
+#ifdef L3D_USE_32BIT_INDICES
+typedef uint32_t l3d_index_t;
+#else
+typedef uint16_t l3d_index_t;
+#endif
 
 // #define L3D_EDGE_FLAGS_SINGLE_BYTE          // PackEdgeFlags = True
 
@@ -150,6 +208,8 @@
 #define L3D_EDGE_FLAG_SILHOUETTE_BIT    0   // EdgeSilhouetteFlagBitPos = 0
 // #endif  // L3D_EDGE_FLAGS_SINGLE_BYTE
 
+#define L3D_TRI_FLAG_VISIBILITY_BIT     0   // set if the triangle faces the camera
+
 
 // 
 // Camera
@@ -157,6 +217,8 @@
 
 // Camera field of view in degrees
 #define L3D_CAMERA_DEFAULT_FOV 90.0f
+// Height of the view volume of orthographic cameras in world units
+#define L3D_CAMERA_DEFAULT_ORTHO_HEIGHT 10.0f
 #define L3D_CAMERA_DEFAULT_NEAR_PLANE 0.1f
 #define L3D_CAMERA_DEFAULT_FAR_PLANE 1000.0f
 
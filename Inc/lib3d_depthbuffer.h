@@ -0,0 +1,36 @@
+#ifndef _L3D_DEPTHBUFFER_H_
+#define _L3D_DEPTHBUFFER_H_
+
+// 
+// This file contains the depth buffer used for hidden line removal.
+// When REMOVE_HIDDEN_LINES is defined, l3d_processScene() first
+// rasterises depth of every triangle into a buffer of
+// SCREEN_WIDTH x SCREEN_HEIGHT values, then depth-tests every pixel
+// of every edge and draws only visible fragments of it.
+// 
+
+#include "lib3d_config.h"
+
+// Depth of a single pixel: 0 at the near plane, 0xFFFF at the far plane.
+// Also used by the analytical hidden line removal.
+typedef uint16_t l3d_depth_t;
+
+#define L3D_DEPTH_FAR 0xFFFF
+
+#ifdef REMOVE_HIDDEN_LINES
+
+// Line output used by l3d_depthbuffer_drawLine()
+typedef void (*l3d_lineOutput_t)(int32_t x0, int32_t y0, int32_t x1, int32_t y1, l3d_colour_t colour);
+
+void l3d_depthbuffer_clear(void);
+void l3d_depthbuffer_drawTriangle(int32_t x0, int32_t y0, l3d_depth_t z0,
+								  int32_t x1, int32_t y1, l3d_depth_t z1,
+								  int32_t x2, int32_t y2, l3d_depth_t z2);
+void l3d_depthbuffer_drawLine(int32_t x0, int32_t y0, l3d_depth_t z0,
+							  int32_t x1, int32_t y1, l3d_depth_t z1,
+							  l3d_colour_t colour, l3d_lineOutput_t output);
+l3d_depth_t *l3d_depthbuffer_getBuffer(void);
+
+#endif	// REMOVE_HIDDEN_LINES
+
+#endif	// _L3D_DEPTHBUFFER_H_
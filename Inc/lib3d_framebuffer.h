@@ -0,0 +1,31 @@
+#ifndef _L3D_FRAMEBUFFER_H_
+#define _L3D_FRAMEBUFFER_H_
+
+// 
+// This file contains the optional software framebuffer backend.
+// When L3D_USE_FRAMEBUFFER is defined, l3d_processScene()
+// rasterises lines into a buffer of SCREEN_WIDTH x SCREEN_HEIGHT pixels
+// instead of calling l3d_drawLineCallback(),
+// and the user only has to send the finished buffer to the display.
+// 
+
+#include "lib3d_config.h"
+#include "lib3d_math.h"
+
+#ifdef L3D_USE_FRAMEBUFFER
+
+// Single pixel of the framebuffer, rows are stored one after another
+#ifdef COLOUR_SINGLE_BYTE
+typedef uint8_t l3d_pixel_t;
+#else
+typedef l3d_colour_t l3d_pixel_t;
+#endif
+
+void l3d_framebuffer_clear(l3d_colour_t colour);
+void l3d_framebuffer_drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, l3d_colour_t colour);
+void l3d_framebuffer_drawSpan(int32_t y, int32_t x0, int32_t x1, l3d_colour_t colour);
+l3d_pixel_t *l3d_framebuffer_getBuffer(void);
+
+#endif	// L3D_USE_FRAMEBUFFER
+
+#endif	// _L3D_FRAMEBUFFER_H_
@@ -14,6 +14,7 @@
 #define L3D_IS_EDGE_VISISBLE(flags) (flags & (1<<L3D_EDGE_FLAG_VISIBILITY_BIT))
 #define L3D_IS_EDGE_BOUNDARY(flags) (flags & (1<<L3D_EDGE_FLAG_BOUNDARY_BIT))
 #define L3D_IS_EDGE_SILHOUETTE(flags) (flags & (1<<L3D_EDGE_FLAG_SILHOUETTE_BIT))
+#define L3D_IS_TRI_VISIBLE(flags) (flags & (1<<L3D_TRI_FLAG_VISIBILITY_BIT))
 
 // Fixed point arithmetic:
 // Functions taken from javidx9's
@@ -25,9 +26,15 @@ typedef float l3d_flp_t;
 typedef int32_t l3d_fxp_t;
 // Twice-wide fixed point number type
 typedef int64_t l3d_fxp2_t;
-// Number of binary digits after the decimal place
+// Number of binary digits after the decimal place,
+// set by lib3d_fp_format.h with L3D_USE_GENERATED_FP_FORMAT
 // TODO: change the name L3D_FP_DP to sth like L3D_FLP_DP
+#ifndef L3D_FP_DP
 #define L3D_FP_DP 16
+#endif
+#if L3D_FP_DP < 10 || L3D_FP_DP > 24
+#error "L3D_FP_DP must be between 10 and 24"
+#endif
 
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
 // Rational number type (fxp_t for fixed point representation)
@@ -49,6 +56,34 @@ typedef struct {
 	l3d_rtnl_t m[4][4];	// rows, columns
 } l3d_mat4x4_t;
 
+// Affine matrix 3x4:
+// l3d_mat4x4_t without its last column, which is always (0, 0, 0, 1)
+// for rotation / translation (world and view) matrices.
+// Vectors are multiplied from the left (v * M) as well,
+// so rows 0-2 hold the rotation and row 3 the translation.
+typedef struct {
+	l3d_rtnl_t m[4][3];	// rows, columns
+} l3d_mat3x4_t;
+
+#ifdef L3D_USE_QUANTISED_VERTICES
+// Dequantisation of the int16_t model vertices of a mesh:
+// vertex = offset + q * 2^shift, in LSBs of the fixed point format
+typedef struct {
+	l3d_rtnl_t offset[3];	// x, y, z
+	uint8_t shift;			// 0..14
+} l3d_vert_quant_t;
+
+// Affine matrix 3x4 applied to quantised vertices:
+// the rotation in Q1.14 (entries of rigid transforms lie in [-1, 1])
+// and the translation as rationals, with the mesh offset folded in,
+// so that a vertex takes 9 16x16->32 bit multiplications.
+typedef struct {
+	int16_t m[3][3];	// rows, columns
+	l3d_rtnl_t t[3];
+	uint8_t shift;		// of the Q1.14 products down to rationals
+} l3d_mat3x4q_t;
+#endif
+
 // 4D vector:
 typedef struct {
 	l3d_rtnl_t x;
@@ -65,6 +100,23 @@ typedef struct {
 	l3d_rtnl_t z;	// ...
 } l3d_quat_t;
 
+// Plane given by equation a*x + b*y + c*z + d = 0
+// Points for which the left side is positive lie in front of the plane
+typedef struct {
+	l3d_rtnl_t a;
+	l3d_rtnl_t b;
+	l3d_rtnl_t c;
+	l3d_rtnl_t d;
+} l3d_plane_t;
+
+// Axis-aligned rectangle in integer screen coordinates, bounds inclusive
+typedef struct {
+	int32_t x_min;
+	int32_t y_min;
+	int32_t x_max;
+	int32_t y_max;
+} l3d_rect_t;
+
 // Is it needed anymore?
 // Edge:
 // typedef struct {
@@ -90,32 +142,70 @@ typedef struct {
 // 
 // Converting functions
 // 
+#ifdef L3D_USE_INTEGER_ONLY
+// Conversions from floating point are macros in this mode,
+// so that constants get converted by the compiler.
+// Do not pass them anything but constants.
+#define l3d_floatToFixed(num) ((l3d_fxp_t)( (l3d_flp_t)(num) * (l3d_flp_t)( 1 << L3D_FP_DP ) + ( (l3d_flp_t)(num) >= 0 ? 0.5 : -0.5 ) ))
+#define l3d_floatToRational(num) l3d_floatToFixed(num)
+#define l3d_getRotFromFloat(yaw, pitch, roll) ((l3d_rot_t){ l3d_floatToFixed(yaw), l3d_floatToFixed(pitch), l3d_floatToFixed(roll) })
+#define l3d_getVec4FromFloat(x, y, z, h) ((l3d_vec4_t){ l3d_floatToFixed(x), l3d_floatToFixed(y), l3d_floatToFixed(z), l3d_floatToFixed(h) })
+#define l3d_getQuatFromFloat(w, x, y, z) ((l3d_quat_t){ l3d_floatToFixed(w), l3d_floatToFixed(x), l3d_floatToFixed(y), l3d_floatToFixed(z) })
+#define l3d_eulerAnglesToQuat(yaw, pitch, roll) l3d_eulerToQuat(&l3d_getRotFromFloat(yaw, pitch, roll))
+#define l3d_degToRadF(deg) ((deg) * (L3D_PI / 180.0f))
+#define l3d_radToDegF(rad) ((rad) * (180.0f / L3D_PI))
+#endif
+
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+#ifndef L3D_USE_INTEGER_ONLY
 l3d_fxp_t l3d_floatToFixed( l3d_flp_t num );
-l3d_flp_t l3d_fixedToFloat( l3d_fxp_t num );
+#endif
+l3d_flp_t l3d_fixedToFloat( l3d_fxp_t num );	// for debug output only with L3D_USE_INTEGER_ONLY
 l3d_fxp_t l3d_fixedMul( l3d_fxp_t a, l3d_fxp_t b );
 l3d_fxp_t l3d_fixedDiv( l3d_fxp_t a, l3d_fxp_t b );
+// Angles in radians
+l3d_fxp_t l3d_fixedSin( l3d_fxp_t angle );
+l3d_fxp_t l3d_fixedCos( l3d_fxp_t angle );
+l3d_fxp_t l3d_fixedAtan2( l3d_fxp_t y, l3d_fxp_t x );
+l3d_fxp_t l3d_fixedAsin( l3d_fxp_t x );
+l3d_fxp_t l3d_fixedSqrt( l3d_fxp_t x );
+l3d_fxp_t l3d_fixedRsqrt( l3d_fxp_t x );	// 1 / sqrt(x)
+#ifdef L3D_COUNT_FIXED_POINT_OVERFLOWS
+// Number of l3d_fixedMul(), l3d_fixedDiv() and perspective divide results
+// saturated since start up or the last reset
+uint32_t l3d_getFixedPointOverflowCount(void);
+void l3d_resetFixedPointOverflowCount(void);
+#endif
 #endif
+#ifndef L3D_USE_INTEGER_ONLY
 l3d_rtnl_t l3d_floatToRational(l3d_flp_t num);
-l3d_flp_t l3d_rationalToFloat(l3d_rtnl_t num);
+#endif
+l3d_flp_t l3d_rationalToFloat(l3d_rtnl_t num);	// for debug output only with L3D_USE_INTEGER_ONLY
 int32_t l3d_rationalToInt32(l3d_rtnl_t num);
+l3d_rtnl_t l3d_int32ToRational(int32_t num);
 
 l3d_rtnl_t l3d_getZeroRtnl(void);
 
 l3d_rot_t l3d_getZeroRot(void);
+#ifndef L3D_USE_INTEGER_ONLY
 l3d_rot_t l3d_getRotFromFloat(l3d_flp_t yaw, l3d_flp_t pitch, l3d_flp_t roll);
+#endif
 
 l3d_rtnl_t l3d_degToRadR(l3d_rtnl_t deg);
 l3d_rtnl_t l3d_radToDegR(l3d_rtnl_t rad);
 
+#ifndef L3D_USE_INTEGER_ONLY
 l3d_flp_t l3d_degToRadF(l3d_flp_t deg);
 l3d_flp_t l3d_radToDegF(l3d_flp_t rad);
+#endif
 
 // 
 // Vector operations
 // 
 l3d_vec4_t l3d_getZeroVec4(void);
+#ifndef L3D_USE_INTEGER_ONLY
 l3d_vec4_t l3d_getVec4FromFloat(l3d_flp_t x, l3d_flp_t y, l3d_flp_t z, l3d_flp_t h);
+#endif
 l3d_vec4_t l3d_vec4_add( const l3d_vec4_t *v1, const l3d_vec4_t *v2 );
 l3d_vec4_t l3d_vec4_sub( const l3d_vec4_t *v1, const l3d_vec4_t *v2 );
 l3d_vec4_t l3d_vec4_mul( const l3d_vec4_t *v, l3d_rtnl_t k );
@@ -131,27 +221,45 @@ l3d_vec4_t l3d_vec4_negate( const l3d_vec4_t *v );
 // Quaternion operations
 // 
 l3d_quat_t l3d_getIdentityQuat(void);	// change name to multiplicative identity?
+#ifndef L3D_USE_INTEGER_ONLY
 l3d_quat_t l3d_getQuatFromFloat(l3d_flp_t w, l3d_flp_t x, l3d_flp_t y, l3d_flp_t z);
+#endif
 l3d_quat_t l3d_quat_add(const l3d_quat_t *q1, const l3d_quat_t *q2);
 l3d_quat_t l3d_quat_mul(const l3d_quat_t *q1, const l3d_quat_t *q2);
 l3d_rtnl_t l3d_quat_norm(const l3d_quat_t *q);
 l3d_quat_t l3d_quat_normalise(const l3d_quat_t *q);
 l3d_quat_t l3d_quat_complexConjugate(const l3d_quat_t *q);
 l3d_quat_t l3d_quat_inverse(const l3d_quat_t *q);
+#ifndef L3D_USE_INTEGER_ONLY
 l3d_quat_t l3d_eulerAnglesToQuat(l3d_flp_t yaw, l3d_flp_t pitch, l3d_flp_t roll);
+#endif
 l3d_quat_t l3d_eulerToQuat(const l3d_rot_t *r);
 // WIP doesn't work
 // l3d_rot_t l3d_quatToEuler(const l3d_quat_t *q);
 void l3d_quatToRotMat(l3d_mat4x4_t *m, const l3d_quat_t *q);
+l3d_quat_t l3d_rotMatToQuat(const l3d_mat4x4_t *m);
+// Rotation by q followed by translation by pos
+void l3d_quatToAffine(l3d_mat3x4_t *m, const l3d_quat_t *q, const l3d_vec4_t *pos);
+l3d_quat_t l3d_affineToQuat(const l3d_mat3x4_t *m);
 l3d_quat_t l3d_axisAngleToQuat(const l3d_vec4_t *axis, l3d_rtnl_t angle_rad);
 l3d_vec4_t l3d_rotateVecByQuat(const l3d_vec4_t *v, const l3d_quat_t *q);
 
+// 
+// Plane operations
+// 
+l3d_plane_t l3d_plane_normalise( const l3d_plane_t *p );
+l3d_rtnl_t l3d_plane_distanceToPoint( const l3d_plane_t *p, const l3d_vec4_t *v );
+
 // 
 // Matrix operations
 // 
 void l3d_mat4x4_addMatrix( l3d_mat4x4_t *m_out, const l3d_mat4x4_t *m1, const l3d_mat4x4_t *m2 );
 void l3d_mat4x4_mulConst( l3d_mat4x4_t *m_out, l3d_mat4x4_t *m_in, l3d_rtnl_t k );
 l3d_vec4_t l3d_mat4x4_mulVec4( const l3d_mat4x4_t *m, const l3d_vec4_t *v );
+// Transform count vertices by m; in and out may be the same array
+void l3d_mat4x4_mulVec4Array( const l3d_mat4x4_t *m, const l3d_vec4_t *in, l3d_vec4_t *out, l3d_index_t count );
+// As above, followed by l3d_clipSpaceToScreenSpace() of every vertex
+void l3d_mat4x4_projectVec4Array( const l3d_mat4x4_t *m, const l3d_vec4_t *in, l3d_vec4_t *out, l3d_index_t count );
 
 void l3d_mat4x4_makeEmpty( l3d_mat4x4_t *m );
 void l3d_mat4x4_makeIdentity( l3d_mat4x4_t *m );
@@ -167,13 +275,41 @@ void l3d_mat4x4_makeRot( l3d_mat4x4_t *m, const l3d_vec4_t *u, l3d_rtnl_t angle_
 
 void l3d_mat4x4_makeTranslation( l3d_mat4x4_t *m, const l3d_vec4_t *delta_pos );
 void l3d_mat4x4_makeProjection( l3d_mat4x4_t *m, l3d_rtnl_t fov_degrees, l3d_rtnl_t aspect_ratio, l3d_rtnl_t near_plane, l3d_rtnl_t far_plane );
+void l3d_mat4x4_makeOrthographic( l3d_mat4x4_t *m, l3d_rtnl_t height, l3d_rtnl_t aspect_ratio, l3d_rtnl_t near_plane, l3d_rtnl_t far_plane );
 void l3d_mat4x4_mulMatrix( l3d_mat4x4_t *m_out, const l3d_mat4x4_t *m1, const l3d_mat4x4_t *m2 );
+// Frustum planes (left, right, bottom, top, near, far) of a view * projection matrix
+void l3d_mat4x4_getFrustumPlanes( l3d_plane_t planes[6], const l3d_mat4x4_t *m, l3d_rtnl_t depth_range );
+
+// 
+// Affine matrix operations
+// (world and view transforms, the 4x4 matrix is needed only for the projection)
+// 
+void l3d_mat3x4_makeIdentity( l3d_mat3x4_t *m );
+void l3d_mat3x4_fromMat4x4( l3d_mat3x4_t *m_out, const l3d_mat4x4_t *m );	// drops the last column
+void l3d_mat3x4_toMat4x4( l3d_mat4x4_t *m_out, const l3d_mat3x4_t *m );
+l3d_vec4_t l3d_mat3x4_mulVec4( const l3d_mat3x4_t *m, const l3d_vec4_t *v );
+// Transform count vertices by m; in and out may be the same array
+void l3d_mat3x4_mulVec4Array( const l3d_mat3x4_t *m, const l3d_vec4_t *in, l3d_vec4_t *out, l3d_index_t count );
+// Transform count points (h = 1) given as interleaved x, y, z into separate x, y, z streams
+void l3d_mat3x4_mulPointStreams( const l3d_mat3x4_t *m, const l3d_rtnl_t *in_xyz, l3d_rtnl_t *out_x, l3d_rtnl_t *out_y, l3d_rtnl_t *out_z, l3d_index_t count );
+#ifdef L3D_USE_QUANTISED_VERTICES
+// Fold dequantisation of the vertices of a mesh into m, which has to be a rigid transform
+void l3d_mat3x4q_fromMat3x4( l3d_mat3x4q_t *m_out, const l3d_mat3x4_t *m, const l3d_vert_quant_t *quant );
+void l3d_mat3x4q_mulVertexArray( const l3d_mat3x4q_t *m, const int16_t *in_xyz, l3d_vec4_t *out, l3d_index_t count );
+void l3d_mat3x4q_mulPointStreams( const l3d_mat3x4q_t *m, const int16_t *in_xyz, l3d_rtnl_t *out_x, l3d_rtnl_t *out_y, l3d_rtnl_t *out_z, l3d_index_t count );
+l3d_vec4_t l3d_dequantiseVertex( const int16_t *q, const l3d_vert_quant_t *quant );
+#endif
+// m1 followed by m2
+void l3d_mat3x4_mulMatrix( l3d_mat3x4_t *m_out, const l3d_mat3x4_t *m1, const l3d_mat3x4_t *m2 );
+void l3d_mat3x4_mulMat4x4( l3d_mat4x4_t *m_out, const l3d_mat3x4_t *m1, const l3d_mat4x4_t *m2 );
+// Orthographic (clip space w = -1) projection followed by the viewport transform
+void l3d_mat3x4_makeScreenTransform( l3d_mat3x4_t *m_out, const l3d_mat4x4_t *m );
 
 #ifdef L3D_CAMERA_MOVABLE
 //  pos - where the object should be
 //  target - "forward" vector for that object
 //  up - "up" vector
-void l3d_mat4x4_pointAt( l3d_mat4x4_t *m_out, const l3d_vec4_t *pos, const l3d_vec4_t *target, const l3d_vec4_t *up );
+void l3d_mat3x4_pointAt( l3d_mat3x4_t *m_out, const l3d_vec4_t *pos, const l3d_vec4_t *target, const l3d_vec4_t *up );
 
 // WIP:
 // void l3d_mat4x4_lookAtRH( l3d_mat4x4_t *m_out, l3d_vec4_t *eye, l3d_vec4_t *target, l3d_vec4_t *up );
@@ -181,16 +317,17 @@ void l3d_mat4x4_pointAt( l3d_mat4x4_t *m_out, const l3d_vec4_t *pos, const l3d_v
 // void l3d_mat4x4_FPS( l3d_mat4x4_t *m_out, l3d_vec4_t *pos, l3d_rtnl_t pitch, l3d_rtnl_t yaw );
 
 // Works only for Rotation/Translation Matrices
-void l3d_mat4x4_quickInverse( l3d_mat4x4_t *m_out, const l3d_mat4x4_t *m );
+void l3d_mat3x4_quickInverse( l3d_mat3x4_t *m_out, const l3d_mat3x4_t *m );
 #endif	// L3D_CAMERA_MOVABLE
 
-/*
-// Will not compile, may be implemented in the future
-#ifdef L3D_USE_SCREEN_CLIPPING
-// Utility
-// Return a point where line intersects with plane given by point and normal
-l3d_vec4_t l3d_intersect_plane(const l3d_vec4_t *plane_point, l3d_vec4_t *plane_normal, const l3d_vec4_t *line_start, const l3d_vec4_t *line_end);
-#endif
-*/
+// 
+// Clipping (in homogeneous coordinates)
+// 
+// Perspective divide and viewport scale; false if v is left in clip space
+bool l3d_clipSpaceToScreenSpace( l3d_vec4_t *v );
+// Return a point where line intersects with plane
+l3d_vec4_t l3d_intersect_plane(const l3d_plane_t *plane, const l3d_vec4_t *line_start, const l3d_vec4_t *line_end);
+bool l3d_clipLineAgainstPlane(const l3d_plane_t *plane, l3d_vec4_t *line_start, l3d_vec4_t *line_end);
+bool l3d_clipLineToRect( int32_t *x0, int32_t *y0, int32_t *x1, int32_t *y1, const l3d_rect_t *r );
 
 #endif // _L3D_MATH3D_H_
@@ -8,17 +8,28 @@
  Fix naming conflict: tri_count / face_count
 */
 
+// Number of model_edge_data entries per edge:
+// vertex 1 ID, vertex 2 ID, face 1 ID, face 2 ID
+#define L3D_EDGE_DATA_STRIDE 4
+// Face 2 ID of edges which belong to a single face (open meshes),
+// the largest l3d_index_t
+#define L3D_EDGE_NO_FACE ((l3d_index_t)-1)
+
 typedef struct {
 	// See EDABA "L05-Physical-level-part-1.pptx" slides 12 & 13
 	// Maybe put indices of the beginning of each mesh inside the scene struct
 	// to allow validation (and program crashes due to wrong memory accesses)?
-	uint16_t model_vert_data_offset;
-	uint16_t model_tri_data_offset;
-	uint16_t model_edge_data_offset;
+	l3d_index_t model_vert_data_offset;
+	l3d_index_t model_tri_data_offset;
+	l3d_index_t model_edge_data_offset;
+	l3d_index_t model_bsphere_data_offset;
+#ifdef L3D_USE_QUANTISED_VERTICES
+	l3d_index_t model_vert_quant_idx;	// of the mesh in model_vert_quant_data
+#endif
 	
-	uint16_t transformed_vertices_offset;
-	uint16_t tris_flags_offset;
-	uint16_t edges_flags_offset;
+	l3d_index_t transformed_vertices_offset;
+	l3d_index_t tris_flags_offset;
+	l3d_index_t edges_flags_offset;
 
 	// vec4_t *verts;				// of the original model
 	// tri_t *tris;				// 
@@ -26,9 +37,9 @@ typedef struct {
 	// vec4_t *verts_world;		// for hidden line removal
 	// vec4_t *verts_projected;	// also for hidden line removal?
 
-	uint16_t tri_count;
-	uint16_t vert_count;
-	uint16_t edge_count;
+	l3d_index_t tri_count;
+	l3d_index_t vert_count;
+	l3d_index_t edge_count;
 } l3d_mesh_t;
 
 // uint32_t mesh_loadP(mesh_t *mesh,
@@ -9,6 +9,28 @@
 #include "lib3d_math.h"
 #include "lib3d_mesh.h"
 
+// 
+// Components of 3D objects stored in separate arrays
+// with L3D_USE_SOA_OBJECTS, see lib3d_scene.h.
+// Their fields have the same meaning as in l3d_obj3d_t.
+// 
+typedef struct {
+	bool visible : 1;
+	bool in_view : 1;
+	bool updated : 1;
+} l3d_obj3d_flags_t;
+
+typedef struct {
+	l3d_vec4_t u[4];
+	l3d_vec4_t u_world[4];
+	l3d_vec4_t u_proj[4];
+} l3d_obj3d_gizmo_t;
+
+typedef struct {
+	l3d_colour_t wireframe_colour;
+	l3d_colour_t fill_colour;
+} l3d_obj3d_colours_t;
+
 typedef struct {
 	l3d_mesh_t mesh;
 
@@ -32,14 +54,20 @@ typedef struct {
 	// uint8_t group;
 
 	l3d_colour_t wireframe_colour;
-	// l3d_colour_t fill_colour;
+	l3d_colour_t fill_colour;	// used only with USE_FILLED_MESHES
 	bool visible;
+	bool in_view;	// bounding sphere intersects the view frustum; set by l3d_processScene()
+#if defined(L3D_USE_DIRTY_RECTANGLES) || defined(REMOVE_HIDDEN_LINES_ANALYTIC)
+	l3d_rect_t screen_rect;	// screen space bounding box in the last drawn frame;
+							// x_min > x_max if not drawn
+#endif
 
 	// change name to e.g. "modified"
 	// meaning sth's changed so the object has to be projected again; 
 	// if colour changed only draw again, no need to project
 	// so maybe a separate flag?
 	// or make a single status variable instead
+	// Cleared by l3d_processScene() once the object is projected
 	bool updated;
 } l3d_obj3d_t;
 
@@ -12,6 +12,14 @@ typedef struct {
 	uint16_t instance_count;
 } l3d_scene_instance_desc_t;
 
+#ifdef L3D_USE_SOA_VERTICES
+#if defined(REMOVE_HIDDEN_LINES) || defined(REMOVE_HIDDEN_LINES_ANALYTIC) || defined(L3D_USE_FUSED_MVP)
+#error "L3D_USE_SOA_VERTICES can not be combined with REMOVE_HIDDEN_LINES(_ANALYTIC) or L3D_USE_FUSED_MVP"
+#endif
+// Screen coordinate of a vertex that has to be projected again when needed
+#define L3D_SCREEN_COORD_NONE INT16_MIN
+#endif
+
 // Scene object type
 typedef enum l3d_dummy_obj_type_enum {
 	L3D_OBJ_TYPE_CAMERA,
@@ -41,25 +49,55 @@ typedef struct {
 
 	// Const, common for all instances of all objects in the scene,
 	// contain unmodified data of all objects in the scene
+#ifdef L3D_USE_QUANTISED_VERTICES
+	const int16_t *model_vert_data;		// of the original model, see l3d_vert_quant_t
+	const l3d_vert_quant_t *model_vert_quant_data;	// of each mesh
+#else
 	const l3d_rtnl_t *model_vert_data;		// of the original model
-	const uint16_t *model_tri_data;
-	const uint16_t *model_edge_data;
+#endif
+	const l3d_index_t *model_tri_data;
+	const l3d_index_t *model_edge_data;
+	const l3d_rtnl_t *model_face_normal_data;	// x, y, z of each face's normal, indexed like model_tri_data
+	const l3d_rtnl_t *model_bsphere_data;	// bounding sphere of each mesh: centre x, y, z, radius;
+											// NULL disables frustum culling
 
-	uint16_t model_vertex_count;
-	uint16_t model_tri_count;
-	uint16_t model_edge_count;
+	l3d_index_t model_vertex_count;
+	l3d_index_t model_tri_count;
+	l3d_index_t model_edge_count;
 
 	// Sizes of these arrays depend on the number of instances of each object in the scene
+#ifdef L3D_USE_SOA_VERTICES
+	l3d_rtnl_t *vertices_world_x;
+	l3d_rtnl_t *vertices_world_y;
+	l3d_rtnl_t *vertices_world_z;
+	int16_t *vertices_screen_x;		// L3D_SCREEN_COORD_NONE if the vertex is behind the near plane
+	int16_t *vertices_screen_y;		// or too far off the screen, see l3d_transformObjectIntoViewSpace()
+#else
 	l3d_vec4_t *vertices_world;	
 	l3d_vec4_t *vertices_projected;
+#endif
 	uint8_t *tri_flags;
 	uint8_t *edge_flags;
 
-	uint16_t transformed_vertex_count;	// = sum[for each object (model_vertex_count	* no_of_object_instances)]
-	uint16_t tri_flag_count;			// = sum[for each object (model_tri_count		* no_of_object_instances)]
-	uint16_t edge_flag_count;			// = sum[for each object (model_edge_count		* no_of_object_instances)]
-
+	l3d_index_t transformed_vertex_count;	// = sum[for each object (model_vertex_count	* no_of_object_instances)]
+	l3d_index_t tri_flag_count;			// = sum[for each object (model_tri_count		* no_of_object_instances)]
+	l3d_index_t edge_flag_count;			// = sum[for each object (model_edge_count		* no_of_object_instances)]
+
+#ifdef L3D_USE_SOA_OBJECTS
+	// Object components, indexed by object id;
+	// per-frame loops touch only the ones they need
+	l3d_mesh_t *object_meshes;
+	l3d_vec4_t *object_positions;
+	l3d_quat_t *object_orientations;
+	l3d_obj3d_flags_t *object_flags;
+	l3d_obj3d_gizmo_t *object_gizmos;
+	l3d_obj3d_colours_t *object_colours;
+#if defined(L3D_USE_DIRTY_RECTANGLES) || defined(REMOVE_HIDDEN_LINES_ANALYTIC)
+	l3d_rect_t *object_screen_rects;
+#endif
+#else
 	l3d_obj3d_t *objects;
+#endif
 	uint16_t object_count;
 
 	l3d_camera_t *cameras;
@@ -67,12 +105,55 @@ typedef struct {
 	uint16_t camera_count;
 
 	l3d_mat4x4_t mat_proj;	// projection matrix
-	l3d_mat4x4_t mat_view;	// view matrix
+	l3d_mat3x4_t mat_view;	// view matrix (affine)
+#ifdef L3D_USE_FUSED_MVP
+	l3d_mat4x4_t mat_view_proj;	// view * projection, recomputed when the camera changes
+#endif
+#ifdef L3D_USE_FRUSTUM_CULLING
+	l3d_plane_t frustum_planes[6];	// in world space, recomputed when the camera changes
+#endif
+#ifdef L3D_USE_DIRTY_RECTANGLES
+	// Non-overlapping screen regions changed by the last l3d_processScene() call
+	l3d_rect_t dirty_rects[L3D_SCENE_DIRTY_RECTS_CAP];
+	uint8_t dirty_rect_count;
+#endif
 
 	// light sources?
 
 } l3d_scene_t;
 
+// 
+// Components of the 3D object with given id, as lvalues.
+// Use these instead of scene->objects[id] so the code works with both object layouts.
+// 
+#ifdef L3D_USE_SOA_OBJECTS
+#define L3D_OBJ_MESH(scene, id)				((scene)->object_meshes[id])
+#define L3D_OBJ_LOCAL_POS(scene, id)		((scene)->object_positions[id])
+#define L3D_OBJ_ORIENTATION(scene, id)		((scene)->object_orientations[id])
+#define L3D_OBJ_VISIBLE(scene, id)			((scene)->object_flags[id].visible)
+#define L3D_OBJ_IN_VIEW(scene, id)			((scene)->object_flags[id].in_view)
+#define L3D_OBJ_UPDATED(scene, id)			((scene)->object_flags[id].updated)
+#define L3D_OBJ_U(scene, id)				((scene)->object_gizmos[id].u)
+#define L3D_OBJ_U_WORLD(scene, id)			((scene)->object_gizmos[id].u_world)
+#define L3D_OBJ_U_PROJ(scene, id)			((scene)->object_gizmos[id].u_proj)
+#define L3D_OBJ_WIREFRAME_COLOUR(scene, id)	((scene)->object_colours[id].wireframe_colour)
+#define L3D_OBJ_FILL_COLOUR(scene, id)		((scene)->object_colours[id].fill_colour)
+#define L3D_OBJ_SCREEN_RECT(scene, id)		((scene)->object_screen_rects[id])
+#else
+#define L3D_OBJ_MESH(scene, id)				((scene)->objects[id].mesh)
+#define L3D_OBJ_LOCAL_POS(scene, id)		((scene)->objects[id].local_pos)
+#define L3D_OBJ_ORIENTATION(scene, id)		((scene)->objects[id].orientation)
+#define L3D_OBJ_VISIBLE(scene, id)			((scene)->objects[id].visible)
+#define L3D_OBJ_IN_VIEW(scene, id)			((scene)->objects[id].in_view)
+#define L3D_OBJ_UPDATED(scene, id)			((scene)->objects[id].updated)
+#define L3D_OBJ_U(scene, id)				((scene)->objects[id].u)
+#define L3D_OBJ_U_WORLD(scene, id)			((scene)->objects[id].u_world)
+#define L3D_OBJ_U_PROJ(scene, id)			((scene)->objects[id].u_proj)
+#define L3D_OBJ_WIREFRAME_COLOUR(scene, id)	((scene)->objects[id].wireframe_colour)
+#define L3D_OBJ_FILL_COLOUR(scene, id)		((scene)->objects[id].fill_colour)
+#define L3D_OBJ_SCREEN_RECT(scene, id)		((scene)->objects[id].screen_rect)
+#endif
+
 // listObjects(): object name?; number of instances; is visible?; location?
 // listCameras()
 // listUsedGroups()?
@@ -85,9 +166,16 @@ l3d_err_t l3d_scene_setObjectLocalPos(l3d_scene_t *scene, l3d_obj_type_t type, u
 l3d_quat_t l3d_scene_getObjectOrientation(const l3d_scene_t *scene, l3d_obj_type_t type, uint16_t idx);
 l3d_err_t l3d_scene_setObjectOrientation(l3d_scene_t *scene, l3d_obj_type_t type, uint16_t idx, const l3d_quat_t *q);
 
+bool l3d_scene_isObjectVisible(const l3d_scene_t *scene, uint16_t idx);
+l3d_err_t l3d_scene_setObjectVisible(l3d_scene_t *scene, uint16_t idx, bool visible);
+
 l3d_vec4_t l3d_scene_getObjectLocalUnitVecX(const l3d_scene_t *scene, l3d_obj_type_t type, uint16_t idx);
 l3d_vec4_t l3d_scene_getObjectLocalUnitVecY(const l3d_scene_t *scene, l3d_obj_type_t type, uint16_t idx);
 l3d_vec4_t l3d_scene_getObjectLocalUnitVecZ(const l3d_scene_t *scene, l3d_obj_type_t type, uint16_t idx);
 // No setters - they would be unsafe
 
+#ifdef L3D_USE_DIRTY_RECTANGLES
+const l3d_rect_t *l3d_scene_getDirtyRects(const l3d_scene_t *scene, uint8_t *count);
+#endif
+
 #endif	// _L3D_SCENE_H_
\ No newline at end of file
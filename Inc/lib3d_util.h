@@ -12,6 +12,30 @@
 // 
 void l3d_drawLineCallback( int32_t x0, int32_t y0, int32_t x1, int32_t y1, l3d_colour_t colour);
 
+// 
+// Draw a horizontal span of pixels from x0 to x1 (inclusive) in row y.
+// Used to fill meshes with USE_FILLED_MESHES.
+// 
+void l3d_drawSpanCallback( int32_t y, int32_t x0, int32_t x1, l3d_colour_t colour );
+
+// 
+// Line in integer screen coordinates, used by the line batching
+// 
+typedef struct {
+	int32_t x0;
+	int32_t y0;
+	int32_t x1;
+	int32_t y1;
+	l3d_colour_t colour;
+} l3d_line_t;
+
+// 
+// Draw count lines on the screen at once.
+// Used instead of l3d_drawLineCallback() with L3D_USE_LINE_BATCHING.
+// Lines of the same colour come one after another.
+// 
+void l3d_drawLinesCallback( const l3d_line_t *lines, uint16_t count );
+
 // 
 // Can be used inside the library itself for debug purposes.
 // 
@@ -115,4 +139,13 @@ void l3d_putInt32Callback( int32_t x, int32_t y, int32_t num, uint8_t digits_cnt
                     l3d_rationalToFloat(mat->m[2][0]), l3d_rationalToFloat(mat->m[2][1]), l3d_rationalToFloat(mat->m[2][2]), l3d_rationalToFloat(mat->m[2][3]), \
                     l3d_rationalToFloat(mat->m[3][0]), l3d_rationalToFloat(mat->m[3][1]), l3d_rationalToFloat(mat->m[3][2]), l3d_rationalToFloat(mat->m[3][3]))
 
+// Print an affine 3x4 matrix via a pointer to it
+// #mat - l3d_mat3x4_t variable name
+#define L3D_DEBUG_PRINT_MAT3X4_P(mat) L3D_DEBUG_PRINT("%s:\n|%.3f, %.3f, %.3f|\n|%.3f, %.3f, %.3f|\n|%.3f, %.3f, %.3f|\n|%.3f, %.3f, %.3f|\n", \
+                    #mat, \
+					l3d_rationalToFloat(mat->m[0][0]), l3d_rationalToFloat(mat->m[0][1]), l3d_rationalToFloat(mat->m[0][2]), \
+                    l3d_rationalToFloat(mat->m[1][0]), l3d_rationalToFloat(mat->m[1][1]), l3d_rationalToFloat(mat->m[1][2]), \
+                    l3d_rationalToFloat(mat->m[2][0]), l3d_rationalToFloat(mat->m[2][1]), l3d_rationalToFloat(mat->m[2][2]), \
+                    l3d_rationalToFloat(mat->m[3][0]), l3d_rationalToFloat(mat->m[3][1]), l3d_rationalToFloat(mat->m[3][2]))
+
 #endif	// _L3D_UTIL_H_
@@ -16,9 +16,10 @@ l3d_err_t l3d_cam_reset(l3d_camera_t *cam){
 	cam->local_look_dir = l3d_getVec4FromFloat(0.0f, 1.0f, 0.0f, 1.0f);	// Y-axis points forward
 	cam->local_up_dir = l3d_getVec4FromFloat(0.0f, 0.0f, 1.0f, 1.0f);	// Z-axis points up
 	cam->fov = l3d_floatToRational(L3D_CAMERA_DEFAULT_FOV);
+	cam->ortho_height = l3d_floatToRational(L3D_CAMERA_DEFAULT_ORTHO_HEIGHT);
 	cam->near_plane = l3d_floatToRational(L3D_CAMERA_DEFAULT_NEAR_PLANE);
 	cam->far_plane = l3d_floatToRational(L3D_CAMERA_DEFAULT_FAR_PLANE);
-	// cam->type = L3D_CAMERA_TYPE_FIRST_PERSON;	// may be implemented in the future
+	cam->type = L3D_CAMERA_TYPE_PERSPECTIVE;
 
 	cam->has_moved = 0;
 	cam->is_modified = 0;
@@ -33,6 +34,15 @@ l3d_err_t l3d_cam_reset(l3d_camera_t *cam){
 // 	return l3d_floatToRational(0.0);
 // }
 
+l3d_err_t l3d_cam_setType(l3d_camera_t *cam, l3d_camera_type_t type) {
+	if (cam == NULL || (type != L3D_CAMERA_TYPE_PERSPECTIVE && type != L3D_CAMERA_TYPE_ORTHOGRAPHIC))
+		return L3D_WRONG_PARAM;
+
+	cam->type = type;
+	cam->is_modified = true;
+	return L3D_OK;
+}
+
 l3d_err_t l3d_cam_setFov(l3d_camera_t *cam, l3d_rtnl_t fov) {
 	if (cam == NULL)
 		return L3D_WRONG_PARAM;
@@ -42,6 +52,15 @@ l3d_err_t l3d_cam_setFov(l3d_camera_t *cam, l3d_rtnl_t fov) {
 	return L3D_OK;
 }
 
+l3d_err_t l3d_cam_setOrthoHeight(l3d_camera_t *cam, l3d_rtnl_t height) {
+	if (cam == NULL || height <= l3d_floatToRational(0.0f))
+		return L3D_WRONG_PARAM;
+
+	cam->ortho_height = height;
+	cam->is_modified = true;
+	return L3D_OK;
+}
+
 l3d_err_t l3d_cam_setNearPlane(l3d_camera_t *cam, l3d_rtnl_t near_plane) {
 	if (cam == NULL)
 		return L3D_WRONG_PARAM;
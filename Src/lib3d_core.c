@@ -4,6 +4,13 @@
 l3d_vec4_t global_axes_world[4]; // origin, X, Y, Z
 l3d_vec4_t global_axes_proj[4]; // origin, X, Y, Z
 
+#ifdef L3D_USE_LINE_BATCHING
+// Caller-provided buffer of lines waiting to be drawn
+static l3d_line_t *line_buffer = NULL;
+static uint16_t line_buffer_cap = 0;
+static uint16_t line_count = 0;
+#endif
+
 // 
 // Init the marker of the origin of the coordinate system
 // 
@@ -19,6 +26,16 @@ void l3d_initGlobalAxesMarker(void) {
 // mat	- matrix to be set up as a projection mat
 // 
 void l3d_makeProjectionMatrix(l3d_mat4x4_t *mat, const l3d_camera_t *cam){
+	if (cam->type == L3D_CAMERA_TYPE_ORTHOGRAPHIC) {
+		l3d_mat4x4_makeOrthographic(
+				mat,
+				cam->ortho_height,
+				l3d_floatToRational( (l3d_flp_t)SCREEN_HEIGHT / (l3d_flp_t)SCREEN_WIDTH ),
+				cam->near_plane,
+				cam->far_plane );
+		return;
+	}
+
 	l3d_mat4x4_makeProjection(
 			mat,
 			cam->fov,
@@ -33,38 +50,70 @@ void l3d_makeProjectionMatrix(l3d_mat4x4_t *mat, const l3d_camera_t *cam){
 // cam				- camera
 // mat_view			- view matrix
 // 
-void l3d_computeViewMatrix( l3d_camera_t *cam, l3d_mat4x4_t *mat_view ){
+void l3d_computeViewMatrix( l3d_camera_t *cam, l3d_mat3x4_t *mat_view ){
 	cam->orientation = l3d_quat_normalise(&cam->orientation);
 
-	l3d_mat4x4_t mat_cam_rot;
-	l3d_quatToRotMat(&mat_cam_rot, &cam->orientation);
+	l3d_mat3x4_t mat_cam_rot;
+	l3d_vec4_t origin = l3d_getZeroVec4();
+	l3d_quatToAffine(&mat_cam_rot, &cam->orientation, &origin);
 	
 	l3d_vec4_t v_target = l3d_getVec4FromFloat(0.0f, 1.0f, 0.0f, 1.0f); // Y-axis points forward
-	cam->local_look_dir = l3d_mat4x4_mulVec4( &mat_cam_rot, &v_target );
+	cam->local_look_dir = l3d_mat3x4_mulVec4( &mat_cam_rot, &v_target );
 
 	l3d_vec4_t up_dir = l3d_getVec4FromFloat(0.0f, 0.0f, 1.0f, 1.0f);	// Z axis points up
-	l3d_quatToRotMat(&mat_cam_rot, &cam->orientation);
-	cam->local_up_dir = l3d_mat4x4_mulVec4( &mat_cam_rot, &up_dir );
+	cam->local_up_dir = l3d_mat3x4_mulVec4( &mat_cam_rot, &up_dir );
 
-    l3d_mat4x4_t mat_camera;
+    l3d_mat3x4_t mat_camera;
 	v_target = l3d_vec4_add( &(cam->local_pos), &(cam->local_look_dir) );
-	// l3d_mat4x4_pointAt( &mat_camera, &(cam->local_pos), &v_target, &v_up );
-	l3d_mat4x4_pointAt( &mat_camera, &(cam->local_pos), &v_target, &(cam->local_up_dir) );
+	// l3d_mat3x4_pointAt( &mat_camera, &(cam->local_pos), &v_target, &v_up );
+	l3d_mat3x4_pointAt( &mat_camera, &(cam->local_pos), &v_target, &(cam->local_up_dir) );
 
     // Make view matrix from camera:
-    l3d_mat4x4_quickInverse( mat_view, &mat_camera );
+    l3d_mat3x4_quickInverse( mat_view, &mat_camera );
 }
 #else
-void l3d_computeViewMatrix( l3d_camera_t *cam, l3d_mat4x4_t *mat_view ) {
+void l3d_computeViewMatrix( l3d_camera_t *cam, l3d_mat3x4_t *mat_view ) {
+
+}
+#endif
 
+// 
+// Make world matrix of an object
+// (rotate and then translate the object)
+// mat_world		- output matrix
+// pos			- object's position
+// orientation	- object's orientation
+// 
+void l3d_computeWorldMatrix(l3d_mat3x4_t *mat_world, const l3d_vec4_t *pos, const l3d_quat_t *orientation) {
+	// Rotation matrix with the translation in its last row,
+	// no matrix product needed
+	l3d_quatToAffine(mat_world, orientation, pos);
 }
+
+// 
+// Vertex of the unmodified model data of a mesh, in model space
+// 
+static inline l3d_vec4_t getModelVertex(const l3d_scene_t *scene, const l3d_mesh_t *mesh, l3d_index_t v_id) {
+#ifdef L3D_USE_QUANTISED_VERTICES
+	return l3d_dequantiseVertex(&scene->model_vert_data[mesh->model_vert_data_offset + v_id*3],
+		&scene->model_vert_quant_data[mesh->model_vert_quant_idx]);
+#else
+	return (l3d_vec4_t){
+		scene->model_vert_data[mesh->model_vert_data_offset + v_id*3 + 0],
+		scene->model_vert_data[mesh->model_vert_data_offset + v_id*3 + 1],
+		scene->model_vert_data[mesh->model_vert_data_offset + v_id*3 + 2],
+		l3d_floatToRational(1.0f)
+	};
 #endif
+}
 
 // 
 // Raw model data -> object in the scene (in world space)
 // 
-void l3d_transformObjectIntoWorldSpace(l3d_scene_t *scene, l3d_obj_type_t type, uint16_t idx, const l3d_mat4x4_t *mat_world) {
-	l3d_obj3d_t *obj3d = NULL;
+void l3d_transformObjectIntoWorldSpace(l3d_scene_t *scene, l3d_obj_type_t type, uint16_t idx, const l3d_mat3x4_t *mat_world) {
+	const l3d_mesh_t *mesh = NULL;
+	const l3d_vec4_t *u = NULL;
+	l3d_vec4_t *u_world = NULL;
 	l3d_camera_t *cam = NULL;
 	switch (type) {
 		case L3D_OBJ_TYPE_CAMERA:
@@ -72,96 +121,282 @@ void l3d_transformObjectIntoWorldSpace(l3d_scene_t *scene, l3d_obj_type_t type,
 			if (cam == NULL)
 				return;
 			// Transform orientation markers into world space
-			cam->u_world[0] = l3d_mat4x4_mulVec4(mat_world, &cam->u[0]);	// TODO?: replace this with l3d_getVec4FromFloat(0.0f, 0.0f, 0.0f, 1.0f) etc.
-			cam->u_world[1] = l3d_mat4x4_mulVec4(mat_world, &cam->u[1]);
-			cam->u_world[2] = l3d_mat4x4_mulVec4(mat_world, &cam->u[2]);
-			cam->u_world[3] = l3d_mat4x4_mulVec4(mat_world, &cam->u[3]);
+			cam->u_world[0] = l3d_mat3x4_mulVec4(mat_world, &cam->u[0]);	// TODO?: replace this with l3d_getVec4FromFloat(0.0f, 0.0f, 0.0f, 1.0f) etc.
+			cam->u_world[1] = l3d_mat3x4_mulVec4(mat_world, &cam->u[1]);
+			cam->u_world[2] = l3d_mat3x4_mulVec4(mat_world, &cam->u[2]);
+			cam->u_world[3] = l3d_mat3x4_mulVec4(mat_world, &cam->u[3]);
 			break;
 		case L3D_OBJ_TYPE_OBJ3D:
-			obj3d = &scene->objects[idx];
-			if (obj3d == NULL)
+			if (idx >= scene->object_count)
 				return;
 			// Transform all vertices of current object to world space
-			uint16_t vert_count = obj3d->mesh.vert_count;
-			uint16_t model_vert_data_offset = obj3d->mesh.model_vert_data_offset;
-			uint16_t tr_vert_offset = obj3d->mesh.transformed_vertices_offset;
+			mesh = &L3D_OBJ_MESH(scene, idx);
+			l3d_index_t vert_count = mesh->vert_count;
+			l3d_index_t tr_vert_offset = mesh->transformed_vertices_offset;
 
 			// L3D_DEBUG_PRINT("obj idx: %d; vert_count = %d, model_vert_data_offset = %d, tr_vert_offset = %d\n",
 			// 				idx, vert_count, model_vert_data_offset, tr_vert_offset);
 			
-			// L3D_DEBUG_PRINT_MAT4X4(mat_world);
+			// L3D_DEBUG_PRINT_MAT3X4_P(mat_world);
 
-			for (uint16_t v_id = 0; v_id < vert_count; v_id++) {
+#ifdef L3D_USE_QUANTISED_VERTICES
+			// Dequantise while transforming, without 64 bit arithmetic
+			l3d_index_t model_vert_data_offset = mesh->model_vert_data_offset;
+			l3d_mat3x4q_t mat_world_q;
+			l3d_mat3x4q_fromMat3x4(&mat_world_q, mat_world, &scene->model_vert_quant_data[mesh->model_vert_quant_idx]);
+#ifdef L3D_USE_SOA_VERTICES
+			l3d_mat3x4q_mulPointStreams(&mat_world_q, &scene->model_vert_data[model_vert_data_offset],
+				&scene->vertices_world_x[tr_vert_offset],
+				&scene->vertices_world_y[tr_vert_offset],
+				&scene->vertices_world_z[tr_vert_offset],
+				vert_count);
+#else
+			l3d_mat3x4q_mulVertexArray(&mat_world_q, &scene->model_vert_data[model_vert_data_offset],
+				&scene->vertices_world[tr_vert_offset], vert_count);
+#endif
+#elif defined(L3D_USE_SOA_VERTICES)
+			l3d_index_t model_vert_data_offset = mesh->model_vert_data_offset;
+			l3d_mat3x4_mulPointStreams(mat_world, &scene->model_vert_data[model_vert_data_offset],
+				&scene->vertices_world_x[tr_vert_offset],
+				&scene->vertices_world_y[tr_vert_offset],
+				&scene->vertices_world_z[tr_vert_offset],
+				vert_count);
+#else
+			l3d_vec4_t *vertices = &scene->vertices_world[tr_vert_offset];
+			for (l3d_index_t v_id = 0; v_id < vert_count; v_id++) {
 				// Get vertex from vertex data of current object's mesh
-				l3d_vec4_t vertex = {
-					scene->model_vert_data[model_vert_data_offset + v_id*3 + 0],
-					scene->model_vert_data[model_vert_data_offset + v_id*3 + 1],
-					scene->model_vert_data[model_vert_data_offset + v_id*3 + 2],
-					l3d_floatToRational(1.0f)
-				};
-
-				l3d_vec4_t v_world = l3d_mat4x4_mulVec4(mat_world, &vertex);
-
-				scene->vertices_world[tr_vert_offset + v_id] = v_world; // shallow copy is sufficient
-
-				// L3D_DEBUG_PRINT("v_id %d: data idx's: (%d, %d, %d)\n", v_id,
-				// 	model_vert_data_offset + v_id*3 + 0, model_vert_data_offset + v_id*3 + 1, model_vert_data_offset + v_id*3 + 2);
-				// L3D_DEBUG_PRINT("stored into: scene->vertices_world[%d]\n", tr_vert_offset + v_id);
+				vertices[v_id] = getModelVertex(scene, mesh, v_id);
 			}
 
+			// Then transform them all at once, in place
+			l3d_mat3x4_mulVec4Array(mat_world, vertices, vertices, vert_count);
+#endif
+
 			// Transform orientation markers into world space
-			obj3d->u_world[0] = l3d_mat4x4_mulVec4(mat_world, &obj3d->u[0]);	// TODO?: replace this with l3d_getVec4FromFloat(0.0f, 0.0f, 0.0f, 1.0f) etc.
-			obj3d->u_world[1] = l3d_mat4x4_mulVec4(mat_world, &obj3d->u[1]);
-			obj3d->u_world[2] = l3d_mat4x4_mulVec4(mat_world, &obj3d->u[2]);
-			obj3d->u_world[3] = l3d_mat4x4_mulVec4(mat_world, &obj3d->u[3]);
+			u = L3D_OBJ_U(scene, idx);
+			u_world = L3D_OBJ_U_WORLD(scene, idx);
+			u_world[0] = l3d_mat3x4_mulVec4(mat_world, &u[0]);	// TODO?: replace this with l3d_getVec4FromFloat(0.0f, 0.0f, 0.0f, 1.0f) etc.
+			u_world[1] = l3d_mat3x4_mulVec4(mat_world, &u[1]);
+			u_world[2] = l3d_mat3x4_mulVec4(mat_world, &u[2]);
+			u_world[3] = l3d_mat3x4_mulVec4(mat_world, &u[3]);
 			break;
 	}
 }
 
+// 
+// Recompute world space data of an object
+// from its pose and unmodified model data
+// 
+static void updateObjectWorldSpace(l3d_scene_t *scene, l3d_obj_type_t type, uint16_t idx) {
+	l3d_mat3x4_t mat_world;
+	l3d_vec4_t pos = l3d_scene_getObjectLocalPos(scene, type, idx);
+	l3d_quat_t orientation = l3d_scene_getObjectOrientation(scene, type, idx);
+	orientation = l3d_quat_normalise(&orientation);
+	l3d_computeWorldMatrix(&mat_world, &pos, &orientation);
+	l3d_transformObjectIntoWorldSpace(scene, type, idx, &mat_world);
+}
+
+// 
+// Check whether a vertex has been projected onto the screen
+// by l3d_clipSpaceToScreenSpace() or is still given in clip space.
+// 
+static bool isVertexProjected(const l3d_vec4_t *v) {
+	return v->z >= l3d_floatToRational(0.0f) && v->h > l3d_floatToRational(0.0f);
+}
+
+// 
+// Inverse of l3d_clipSpaceToScreenSpace().
+// Recover clip space coordinates of a projected vertex.
+// 
+static l3d_vec4_t screenSpaceToClipSpace(const l3d_vec4_t *v) {
+	l3d_rtnl_t w = -v->h;
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+	l3d_rtnl_t x = l3d_fixedDiv(v->x, l3d_floatToFixed(0.5f * (l3d_flp_t)SCREEN_WIDTH)) - l3d_floatToFixed(1.0f);
+	l3d_rtnl_t y = l3d_fixedDiv(v->y, l3d_floatToFixed(0.5f * (l3d_flp_t)SCREEN_HEIGHT)) - l3d_floatToFixed(1.0f);
+	return (l3d_vec4_t){ l3d_fixedMul(x, w), l3d_fixedMul(y, w), l3d_fixedMul(v->z, v->h), w };
+#else
+	l3d_rtnl_t x = v->x / (0.5f * (l3d_flp_t)SCREEN_WIDTH) - 1.0f;
+	l3d_rtnl_t y = v->y / (0.5f * (l3d_flp_t)SCREEN_HEIGHT) - 1.0f;
+	return (l3d_vec4_t){ x * w, y * w, v->z * v->h, w };
+#endif
+}
+
+// 
+// Orthographic projection matrices keep clip space w at -1
+// (m[2][3] is 0 instead of -1), nothing has to be divided.
+// 
+static bool isProjectionAffine(const l3d_mat4x4_t *mat_proj) {
+	return mat_proj->m[2][3] == l3d_floatToRational(0.0f);
+}
+
+// 
+// Project vertices by an orthographic projection matrix
+// (possibly preceded by affine matrices) in a single multiply-add pass,
+// with the viewport transform folded into the matrix.
+// Vertices behind the near plane are turned back into clip space,
+// like l3d_clipSpaceToScreenSpace() leaves them.
+// 
+static void projectVec4ArrayAffine(const l3d_mat4x4_t *mat_clip, const l3d_vec4_t *input_array, l3d_vec4_t *output_array, l3d_index_t arr_size) {
+	l3d_mat3x4_t mat_screen;
+	l3d_mat3x4_makeScreenTransform(&mat_screen, mat_clip);
+	l3d_mat3x4_mulVec4Array(&mat_screen, input_array, output_array, arr_size);
+
+	for (l3d_index_t i = 0; i < arr_size; i++) {
+		if (output_array[i].z < l3d_floatToRational(0.0f))
+			output_array[i] = screenSpaceToClipSpace(&output_array[i]);
+	}
+}
+
 // 
 // Transform all vertices of the input array to view space,
 // project them onto 2D screen coordinates,
 // and put into the output array.
+// Orthographic projections are done without the perspective divide,
+// view, projection and viewport transforms make a single affine matrix.
 // 
 // arr_size - size of both arrays
 // 
-void transformVertexArrayIntoViewSpace(const l3d_vec4_t *input_array, l3d_vec4_t *output_array, uint16_t arr_size, const l3d_mat4x4_t *mat_view, const l3d_mat4x4_t *mat_proj) {
-	for (uint16_t v_id = 0; v_id < arr_size; v_id++ ) {
-		l3d_vec4_t v_world = input_array[v_id];
+void transformVertexArrayIntoViewSpace(const l3d_vec4_t *input_array, l3d_vec4_t *output_array, l3d_index_t arr_size, const l3d_mat3x4_t *mat_view, const l3d_mat4x4_t *mat_proj) {
+	// Vertices behind the camera are kept in clip space
 #ifdef L3D_CAMERA_MOVABLE
-		l3d_vec4_t v_viewed = l3d_mat4x4_mulVec4(mat_view, &v_world);
-		l3d_vec4_t v_projected = l3d_mat4x4_mulVec4(mat_proj, &v_viewed);
+	if (isProjectionAffine(mat_proj)) {
+		l3d_mat4x4_t mat_view_proj;
+		l3d_mat3x4_mulMat4x4(&mat_view_proj, mat_view, mat_proj);
+		projectVec4ArrayAffine(&mat_view_proj, input_array, output_array, arr_size);
+		return;
+	}
+
+	// The output array holds view space vertices in between
+	l3d_mat3x4_mulVec4Array(mat_view, input_array, output_array, arr_size);
+	l3d_mat4x4_projectVec4Array(mat_proj, output_array, output_array, arr_size);
 #else
-		l3d_vec4_t v_projected = l3d_mat4x4_mulVec4(mat_proj, &v_world);
+	if (isProjectionAffine(mat_proj))
+		projectVec4ArrayAffine(mat_proj, input_array, output_array, arr_size);
+	else
+		l3d_mat4x4_projectVec4Array(mat_proj, input_array, output_array, arr_size);
 #endif
-		// Scale into view, we moved the normalising into cartesian space
-		// out of the matrix.vector function from the previous versions, so
-		// do this manually:
-		if (v_projected.h == l3d_floatToRational(0.0f)) {
-			L3D_DEBUG_PRINT("Error: Division by zero. Aborting\n");
-			return;
-		}
-		v_projected = l3d_vec4_div(&v_projected, v_projected.h);
+}
+
+#ifdef L3D_USE_FUSED_MVP
+// 
+// Project all vertices of an object straight from the raw model data
+// onto 2D screen coordinates, using a single matrix per object
+// (world * view * projection) instead of transforming
+// the vertices into world space first.
+// 
+void transformModelIntoScreenSpace(l3d_scene_t *scene, uint16_t obj_id) {
+	l3d_mat3x4_t mat_world;
+	l3d_mat4x4_t mat_mvp;
+	l3d_computeWorldMatrix(&mat_world, &L3D_OBJ_LOCAL_POS(scene, obj_id), &L3D_OBJ_ORIENTATION(scene, obj_id));
+	l3d_mat3x4_mulMat4x4(&mat_mvp, &mat_world, &scene->mat_view_proj);
 
-		l3d_vec4_t v_offset_view = l3d_getVec4FromFloat(1.0f, 1.0f, 0.0f, 0.0f);
+	const l3d_mesh_t *mesh = &L3D_OBJ_MESH(scene, obj_id);
+	l3d_index_t vert_count = mesh->vert_count;
+	l3d_index_t tr_vert_offset = mesh->transformed_vertices_offset;
 
-		v_projected = l3d_vec4_add(&v_projected, &v_offset_view);
+	l3d_vec4_t *vertices = &scene->vertices_projected[tr_vert_offset];
+	for (l3d_index_t v_id = 0; v_id < vert_count; v_id++)
+		vertices[v_id] = getModelVertex(scene, mesh, v_id);
 
-#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
-		v_projected.x = l3d_fixedMul(v_projected.x, l3d_floatToFixed(0.5f * (l3d_flp_t)SCREEN_WIDTH));
-		v_projected.y = l3d_fixedMul(v_projected.y, l3d_floatToFixed(0.5f * (l3d_flp_t)SCREEN_HEIGHT));
+	// Vertices behind the camera are kept in clip space
+	if (isProjectionAffine(&scene->mat_proj))
+		projectVec4ArrayAffine(&mat_mvp, vertices, vertices, vert_count);
+	else
+		l3d_mat4x4_projectVec4Array(&mat_mvp, vertices, vertices, vert_count);
+
+	// Orientation markers are given in model space aswell
+	const l3d_vec4_t *u = L3D_OBJ_U(scene, obj_id);
+	l3d_vec4_t *u_proj = L3D_OBJ_U_PROJ(scene, obj_id);
+	for (uint8_t i = 0; i < 4; i++) {
+		l3d_vec4_t v_projected = l3d_mat4x4_mulVec4(&mat_mvp, &u[i]);
+		l3d_clipSpaceToScreenSpace(&v_projected);
+		u_proj[i] = v_projected;
+	}
+}
+#endif	// L3D_USE_FUSED_MVP
+
+#ifdef L3D_USE_SOA_VERTICES
+// Vertices projected at once by projectVertexStreams()
+#define L3D_SOA_CHUNK_SIZE 16
+
+static l3d_vec4_t getWorldVertex(const l3d_scene_t *scene, l3d_index_t v_id) {
+	return (l3d_vec4_t){
+		scene->vertices_world_x[v_id],
+		scene->vertices_world_y[v_id],
+		scene->vertices_world_z[v_id],
+		l3d_floatToRational(1.0f)
+	};
+}
+
+// 
+// Project a world space vertex of the scene exactly like
+// transformVertexArrayIntoViewSpace() does, without
+// rounding it to integer screen coordinates.
+// 
+static l3d_vec4_t projectWorldVertex(const l3d_scene_t *scene, l3d_index_t v_id) {
+	l3d_vec4_t v = getWorldVertex(scene, v_id);
+	transformVertexArrayIntoViewSpace(&v, &v, 1, &scene->mat_view, &scene->mat_proj);
+	return v;
+}
+
+static bool fitsScreenCoord(l3d_rtnl_t c) {
+#if defined(L3D_USE_FIXED_POINT_ARITHMETIC) && L3D_FP_DP > 16
+	// The integer part of any rational lies within int16_t then
+	(void)c;
+	return true;
 #else
-		v_projected.x *= 0.5f * (l3d_flp_t)SCREEN_WIDTH;
-		v_projected.y *= 0.5f * (l3d_flp_t)SCREEN_HEIGHT;
+	return c > l3d_floatToRational(-32767.0f) && c < l3d_floatToRational(32767.0f);
 #endif
+}
+
+// 
+// Project world space vertex streams onto the screen in chunks
+// and store integer screen coordinates of the vertices.
+// Vertices behind the near plane or too far off the screen
+// are marked with L3D_SCREEN_COORD_NONE.
+// 
+static void projectVertexStreams(l3d_scene_t *scene, l3d_index_t first_v_id, l3d_index_t count) {
+	l3d_vec4_t chunk[L3D_SOA_CHUNK_SIZE];
 
-		// Update the projected vertex
-		output_array[v_id] = v_projected;
+	for (l3d_index_t done = 0; done < count; done += L3D_SOA_CHUNK_SIZE) {
+		l3d_index_t n = count - done < L3D_SOA_CHUNK_SIZE ? count - done : L3D_SOA_CHUNK_SIZE;
+		for (l3d_index_t i = 0; i < n; i++)
+			chunk[i] = getWorldVertex(scene, first_v_id + done + i);
+
+		transformVertexArrayIntoViewSpace(chunk, chunk, n, &scene->mat_view, &scene->mat_proj);
+
+		for (l3d_index_t i = 0; i < n; i++) {
+			const l3d_vec4_t *v = &chunk[i];
+			bool fits = isVertexProjected(v) && fitsScreenCoord(v->x) && fitsScreenCoord(v->y);
+			scene->vertices_screen_x[first_v_id + done + i] = fits ? (int16_t)l3d_rationalToInt32(v->x) : L3D_SCREEN_COORD_NONE;
+			scene->vertices_screen_y[first_v_id + done + i] = fits ? (int16_t)l3d_rationalToInt32(v->y) : L3D_SCREEN_COORD_NONE;
+		}
 	}
 }
+#endif	// L3D_USE_SOA_VERTICES
+
+// 
+// Projected vertex of the scene, as handled by the drawing functions.
+// With L3D_USE_SOA_VERTICES, only whole screen coordinates are known
+// for vertices stored as such, their depth (z) is 0 and w (h) is 1.
+// 
+static l3d_vec4_t getProjectedVertex(const l3d_scene_t *scene, l3d_index_t v_id) {
+#ifdef L3D_USE_SOA_VERTICES
+	if (scene->vertices_screen_x[v_id] == L3D_SCREEN_COORD_NONE)
+		return projectWorldVertex(scene, v_id);
+	return (l3d_vec4_t){
+		l3d_int32ToRational(scene->vertices_screen_x[v_id]),
+		l3d_int32ToRational(scene->vertices_screen_y[v_id]),
+		l3d_floatToRational(0.0f),
+		l3d_floatToRational(1.0f)
+	};
+#else
+	return scene->vertices_projected[v_id];
+#endif
+}
 
 void l3d_transformObjectIntoViewSpace(l3d_scene_t *scene, l3d_obj_type_t type, uint16_t idx) {
-	l3d_obj3d_t *obj3d = NULL;
+	const l3d_mesh_t *mesh = NULL;
 	switch (type) {
 		case L3D_OBJ_TYPE_CAMERA:
 			// Transforming camera's location marker results in division by 0
@@ -175,25 +410,244 @@ void l3d_transformObjectIntoViewSpace(l3d_scene_t *scene, l3d_obj_type_t type, u
 			// transformVertexArrayIntoViewSpace(cam->u_world, cam->u_proj, 4, &scene->mat_view, &scene->mat_proj);
 			break;
 		case L3D_OBJ_TYPE_OBJ3D:
-			obj3d = &scene->objects[idx];
-			
-			if (obj3d == NULL)
+			if (idx >= scene->object_count)
 				return;
+
+#ifdef L3D_USE_FUSED_MVP
+			transformModelIntoScreenSpace(scene, idx);
+			break;
+#endif
 			
 			// Transform all vertices to view space
-			uint16_t tr_vert_offset = obj3d->mesh.transformed_vertices_offset;
+			mesh = &L3D_OBJ_MESH(scene, idx);
+			l3d_index_t tr_vert_offset = mesh->transformed_vertices_offset;
+			l3d_index_t vert_count = mesh->vert_count;
+#ifdef L3D_USE_SOA_VERTICES
+			projectVertexStreams(scene, tr_vert_offset, vert_count);
+#else
 			l3d_vec4_t *first_v_world_ptr = &scene->vertices_world[tr_vert_offset];
 			l3d_vec4_t *first_v_proj_ptr = &scene->vertices_projected[tr_vert_offset];
-			uint16_t vert_count = obj3d->mesh.vert_count;
 			transformVertexArrayIntoViewSpace(first_v_world_ptr, first_v_proj_ptr, vert_count, &scene->mat_view, &scene->mat_proj);
+#endif
 
 			// Transform orientation markers to view space
-			transformVertexArrayIntoViewSpace(obj3d->u_world, obj3d->u_proj, 4, &scene->mat_view, &scene->mat_proj);
+			transformVertexArrayIntoViewSpace(L3D_OBJ_U_WORLD(scene, idx), L3D_OBJ_U_PROJ(scene, idx), 4, &scene->mat_view, &scene->mat_proj);
+			break;
+	}
+}
+
+#if defined(L3D_RENDER_VISIBLE_ONLY) || defined(DRAW_CONTOUR_ONLY) || defined(REMOVE_HIDDEN_LINES_ANALYTIC) || defined(USE_FILLED_MESHES)
+// 
+// Back-face culling and silhouette extraction of a single object.
+// Mark triangles facing the camera as visible in tri_flags,
+// then mark edges as visible if any of their faces is visible
+// and as silhouette if exactly one of them is visible.
+// The test is done in object space using face normals
+// exported by the model parser, so no vertex has to be transformed.
+// 
+static void updateFaceVisibility(l3d_scene_t *scene, uint16_t obj_id) {
+	if (scene->model_face_normal_data == NULL || scene->tri_flags == NULL)
+		return;
+
+	const l3d_camera_t *cam = l3d_scene_getActiveCamera(scene);
+	const l3d_mesh_t *mesh = &L3D_OBJ_MESH(scene, obj_id);
+
+	// Camera position in object space
+	l3d_vec4_t cam_pos = l3d_vec4_sub(&cam->local_pos, &L3D_OBJ_LOCAL_POS(scene, obj_id));
+	l3d_quat_t q_inv = l3d_quat_normalise(&L3D_OBJ_ORIENTATION(scene, obj_id));
+	q_inv = l3d_quat_inverse(&q_inv);
+	cam_pos = l3d_rotateVecByQuat(&cam_pos, &q_inv);
+
+	// Orthographic cameras look at every face from the same direction
+	bool is_ortho = cam->type == L3D_CAMERA_TYPE_ORTHOGRAPHIC;
+	l3d_vec4_t cam_dir = l3d_vec4_negate(&cam->local_look_dir);
+	cam_dir = l3d_rotateVecByQuat(&cam_dir, &q_inv);
+
+	l3d_index_t tri_data_offset = mesh->model_tri_data_offset;
+	uint8_t *tri_flags = &scene->tri_flags[mesh->tris_flags_offset];
+
+	for (l3d_index_t tri_id = 0; tri_id < mesh->tri_count; tri_id++) {
+		l3d_index_t tri_data_idx = tri_data_offset + tri_id * 3;
+		const l3d_rtnl_t *n = &scene->model_face_normal_data[tri_data_idx];
+
+		// Face is visible if the camera is in front of its plane
+		l3d_vec4_t normal = { n[0], n[1], n[2], l3d_floatToRational(1.0f) };
+		l3d_vec4_t vertex = getModelVertex(scene, mesh, scene->model_tri_data[tri_data_idx]);
+		l3d_vec4_t to_cam = is_ortho ? cam_dir : l3d_vec4_sub(&cam_pos, &vertex);
+
+		if (l3d_vec4_dotProduct(&normal, &to_cam) > l3d_floatToRational(0.0f))
+			tri_flags[tri_id] |= (1 << L3D_TRI_FLAG_VISIBILITY_BIT);
+		else
+			tri_flags[tri_id] &= ~(1 << L3D_TRI_FLAG_VISIBILITY_BIT);
+	}
+
+	l3d_index_t edge_data_offset = mesh->model_edge_data_offset;
+	uint8_t *edge_flags = &scene->edge_flags[mesh->edges_flags_offset];
+
+	for (l3d_index_t edge_id = 0; edge_id < mesh->edge_count; edge_id++) {
+		l3d_index_t edge_data_idx = edge_data_offset + edge_id * L3D_EDGE_DATA_STRIDE;
+		l3d_index_t face1_id = scene->model_edge_data[edge_data_idx + 2];
+		l3d_index_t face2_id = scene->model_edge_data[edge_data_idx + 3];
+
+		bool face1_visible = L3D_IS_TRI_VISIBLE(tri_flags[face1_id]);
+		// Edges of open meshes may belong to a single face only;
+		// treat the missing face as a back-facing one
+		bool face2_visible = (face2_id != L3D_EDGE_NO_FACE) && L3D_IS_TRI_VISIBLE(tri_flags[face2_id]);
+
+		if (face1_visible || face2_visible)
+			edge_flags[edge_id] |= (1 << L3D_EDGE_FLAG_VISIBILITY_BIT);
+		else
+			edge_flags[edge_id] &= ~(1 << L3D_EDGE_FLAG_VISIBILITY_BIT);
+
+		if (face1_visible != face2_visible)
+			edge_flags[edge_id] |= (1 << L3D_EDGE_FLAG_SILHOUETTE_BIT);
+		else
+			edge_flags[edge_id] &= ~(1 << L3D_EDGE_FLAG_SILHOUETTE_BIT);
+	}
+}
+#endif	// L3D_RENDER_VISIBLE_ONLY || DRAW_CONTOUR_ONLY || REMOVE_HIDDEN_LINES_ANALYTIC || USE_FILLED_MESHES
+
+#ifdef L3D_USE_FRUSTUM_CULLING
+// 
+// Check if bounding sphere of an object intersects the view frustum.
+// Objects of scenes without bounding sphere data are always in view.
+// 
+static bool isObjectInFrustum(const l3d_scene_t *scene, uint16_t obj_id) {
+	if (scene->model_bsphere_data == NULL)
+		return true;
+
+	const l3d_rtnl_t *bsphere = &scene->model_bsphere_data[L3D_OBJ_MESH(scene, obj_id).model_bsphere_data_offset];
+	l3d_vec4_t centre = { bsphere[0], bsphere[1], bsphere[2], l3d_floatToRational(1.0f) };
+	l3d_rtnl_t radius = bsphere[3];
+
+	// Model space -> world space
+	// (rigid transformation, so the radius stays the same)
+	l3d_quat_t orientation = l3d_quat_normalise(&L3D_OBJ_ORIENTATION(scene, obj_id));
+	centre = l3d_rotateVecByQuat(&centre, &orientation);
+	centre = l3d_vec4_add(&centre, &L3D_OBJ_LOCAL_POS(scene, obj_id));
+
+	for (uint8_t i = 0; i < 6; i++) {
+		if (l3d_plane_distanceToPoint(&scene->frustum_planes[i], &centre) < -radius)
+			return false;
+	}
+
+	return true;
+}
+#endif	// L3D_USE_FRUSTUM_CULLING
+
+#if defined(L3D_USE_DIRTY_RECTANGLES) || defined(REMOVE_HIDDEN_LINES_ANALYTIC)
+static const l3d_rect_t empty_rect = { 0, 0, -1, -1 };
+
+static bool rectsOverlap(const l3d_rect_t *a, const l3d_rect_t *b) {
+	return a->x_min <= b->x_max && b->x_min <= a->x_max &&
+		   a->y_min <= b->y_max && b->y_min <= a->y_max;
+}
+
+static l3d_rect_t rectUnion(const l3d_rect_t *a, const l3d_rect_t *b) {
+	return (l3d_rect_t){
+		a->x_min < b->x_min ? a->x_min : b->x_min,
+		a->y_min < b->y_min ? a->y_min : b->y_min,
+		a->x_max > b->x_max ? a->x_max : b->x_max,
+		a->y_max > b->y_max ? a->y_max : b->y_max
+	};
+}
+
+// 
+// Screen space bounding box of the projected vertices
+// and orientation markers of an object, limited to the screen.
+// An object crossing the near plane may cover any part of the screen.
+// 
+static l3d_rect_t computeScreenRect(const l3d_scene_t *scene, uint16_t obj_id) {
+	const l3d_rect_t screen = { 0, 0, SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1 };
+	l3d_rect_t r = { INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN };
+	l3d_index_t tr_vert_offset = L3D_OBJ_MESH(scene, obj_id).transformed_vertices_offset;
+	l3d_index_t count = L3D_OBJ_MESH(scene, obj_id).vert_count;
+	const l3d_vec4_t *u_proj = L3D_OBJ_U_PROJ(scene, obj_id);
+
+	for (l3d_index_t i = 0; i < count + 4; i++) {
+		l3d_vec4_t vertex = i < count ? getProjectedVertex(scene, tr_vert_offset + i) : u_proj[i - count];
+		const l3d_vec4_t *v = &vertex;
+		if (!isVertexProjected(v))
+			return screen;
+		int32_t x = l3d_rationalToInt32(v->x);
+		int32_t y = l3d_rationalToInt32(v->y);
+		r = rectUnion(&r, &(l3d_rect_t){ x, y, x, y });
+	}
+
+	if (!rectsOverlap(&r, &screen))
+		return empty_rect;
+	return (l3d_rect_t){
+		r.x_min > 0 ? r.x_min : 0,
+		r.y_min > 0 ? r.y_min : 0,
+		r.x_max < screen.x_max ? r.x_max : screen.x_max,
+		r.y_max < screen.y_max ? r.y_max : screen.y_max
+	};
+}
+#endif	// L3D_USE_DIRTY_RECTANGLES || REMOVE_HIDDEN_LINES_ANALYTIC
+
+#ifdef L3D_USE_DIRTY_RECTANGLES
+static bool isRectEmpty(const l3d_rect_t *r) {
+	return r->x_min > r->x_max || r->y_min > r->y_max;
+}
+
+static bool rectsEqual(const l3d_rect_t *a, const l3d_rect_t *b) {
+	return a->x_min == b->x_min && a->y_min == b->y_min &&
+		   a->x_max == b->x_max && a->y_max == b->y_max;
+}
+
+// 
+// Add rectangle to the scene's dirty list,
+// merging it with every rectangle it overlaps.
+// When the list is full, the new rectangle is merged with the last one.
+// 
+static void addDirtyRect(l3d_scene_t *scene, const l3d_rect_t *r) {
+	if (isRectEmpty(r))
+		return;
+
+	l3d_rect_t merged = *r;
+	while (true) {
+		bool absorbed = false;
+		for (uint8_t i = 0; i < scene->dirty_rect_count; i++) {
+			if (rectsOverlap(&merged, &scene->dirty_rects[i])) {
+				merged = rectUnion(&merged, &scene->dirty_rects[i]);
+				scene->dirty_rects[i] = scene->dirty_rects[--scene->dirty_rect_count];
+				absorbed = true;
+				break;
+			}
+		}
+		// The union may overlap rectangles checked before
+		if (absorbed)
+			continue;
+		if (scene->dirty_rect_count < L3D_SCENE_DIRTY_RECTS_CAP)
 			break;
+		merged = rectUnion(&merged, &scene->dirty_rects[--scene->dirty_rect_count]);
+	}
+	scene->dirty_rects[scene->dirty_rect_count++] = merged;
+}
+
+// 
+// Update object's screen space bounding box after it has been processed.
+// Both the old and the new box are dirty if the object has been projected again
+// (its edges may have changed even if the box has not)
+// or if it has been hidden or shown.
+// 
+static void updateScreenRect(l3d_scene_t *scene, uint16_t obj_id, bool drawn, bool reprojected) {
+	l3d_rect_t *screen_rect = &L3D_OBJ_SCREEN_RECT(scene, obj_id);
+	l3d_rect_t r = *screen_rect;
+	if (!drawn)
+		r = empty_rect;
+	else if (reprojected)
+		r = computeScreenRect(scene, obj_id);
+
+	if (reprojected || !rectsEqual(&r, screen_rect)) {
+		addDirtyRect(scene, screen_rect);
+		addDirtyRect(scene, &r);
 	}
+	*screen_rect = r;
 }
+#endif	// L3D_USE_DIRTY_RECTANGLES
 
-void l3d_transformGlobalAxesMarkerIntoViewSpace(const l3d_mat4x4_t *mat_view, const l3d_mat4x4_t *mat_proj) {
+void l3d_transformGlobalAxesMarkerIntoViewSpace(const l3d_mat3x4_t *mat_view, const l3d_mat4x4_t *mat_proj) {
 	transformVertexArrayIntoViewSpace(global_axes_world, global_axes_proj, 4, mat_view, mat_proj);
 }
 
@@ -206,9 +660,7 @@ l3d_err_t l3d_setupObjects(l3d_scene_t *scene) {
 		return L3D_WRONG_PARAM;
 	
 	// Process each object's vertices
-	l3d_obj3d_t *obj3d = NULL;
 	l3d_camera_t *cam = NULL;
-	l3d_mat4x4_t mat_trans, mat_rot, mat_world;
 
 	// Cameras
 	for (uint16_t cam_id = 0; cam_id < scene->camera_count; cam_id++) {
@@ -216,74 +668,615 @@ l3d_err_t l3d_setupObjects(l3d_scene_t *scene) {
 		if (cam == NULL)
 			return L3D_DATA_EMPTY;
 
-		// Make world matrix
-		// (rotate and then translate the object)
-		// (order matters)
-		l3d_quatToRotMat(&mat_rot, &cam->orientation);
-		l3d_mat4x4_makeTranslation(&mat_trans, &cam->local_pos);
-		l3d_mat4x4_mulMatrix(&mat_world, &mat_trans, &mat_rot);
+		updateObjectWorldSpace(scene, L3D_OBJ_TYPE_CAMERA, cam_id);
 
-		l3d_transformObjectIntoWorldSpace(scene, L3D_OBJ_TYPE_CAMERA, cam_id, &mat_world);
+		// Everything derived from the active camera (combined matrices,
+		// frustum planes) gets rebuilt by the first l3d_processScene() call
+		if (cam_id == scene->active_camera_idx) {
+			cam->has_moved = true;
+			cam->is_modified = true;
+		}
 	}
 	
 	// Obj3d
 	for (uint16_t obj_id = 0; obj_id < scene->object_count; obj_id++) {
-		obj3d = &(scene->objects[obj_id]);
-		if (obj3d == NULL)
-			return L3D_DATA_EMPTY;
-		
-		// Make world matrix
-		// (rotate and then translate the object)
-		// (order matters)
-		l3d_quatToRotMat(&mat_rot, &obj3d->orientation);
-		l3d_mat4x4_makeTranslation(&mat_trans, &obj3d->local_pos);
-		l3d_mat4x4_mulMatrix(&mat_world, &mat_trans, &mat_rot);
+		updateObjectWorldSpace(scene, L3D_OBJ_TYPE_OBJ3D, obj_id);
 
-		l3d_transformObjectIntoWorldSpace(scene, L3D_OBJ_TYPE_OBJ3D, obj_id, &mat_world);
+		// Make sure the object gets projected in the first frame
+		L3D_OBJ_UPDATED(scene, obj_id) = true;
+#if defined(L3D_USE_DIRTY_RECTANGLES) || defined(REMOVE_HIDDEN_LINES_ANALYTIC)
+		L3D_OBJ_SCREEN_RECT(scene, obj_id) = empty_rect;
+#endif
 	}
 
 	return L3D_OK;
 }
 
+#ifdef L3D_USE_LINE_BATCHING
+// 
+// Set buffer the lines are accumulated in before being passed
+// to l3d_drawLinesCallback(). Lines already in the previous buffer are flushed.
+// Without a buffer every line is passed to l3d_drawLineCallback() right away.
+// 
+void l3d_setLineBuffer(l3d_line_t *buffer, uint16_t capacity) {
+	l3d_flushLines();
+	line_buffer = buffer;
+	line_buffer_cap = buffer == NULL ? 0 : capacity;
+}
+
+// 
+// Pass all buffered lines to l3d_drawLinesCallback(),
+// grouped by colour, so that the driver sets its colour state once per group.
+// Called by l3d_processScene() at the end of every frame.
+// 
+void l3d_flushLines(void) {
+	if (line_count == 0)
+		return;
+
+	// Stable insertion sort by colour; lines of one object
+	// mostly share a colour already, so few of them are moved
+	for (uint16_t i = 1; i < line_count; i++) {
+		l3d_line_t line = line_buffer[i];
+		uint16_t j = i;
+		while (j > 0 && line_buffer[j-1].colour > line.colour) {
+			line_buffer[j] = line_buffer[j-1];
+			j--;
+		}
+		line_buffer[j] = line;
+	}
+
+	l3d_drawLinesCallback(line_buffer, line_count);
+	line_count = 0;
+}
+#endif	// L3D_USE_LINE_BATCHING
+
+// 
+// Pass a line in screen coordinates on to the output:
+// the framebuffer, the line buffer or l3d_drawLineCallback().
+// 
+static void submitLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, l3d_colour_t colour) {
+#if defined(L3D_USE_FRAMEBUFFER)
+	l3d_framebuffer_drawLine(x0, y0, x1, y1, colour);
+#elif defined(L3D_USE_LINE_BATCHING)
+	if (line_buffer_cap == 0) {
+		l3d_drawLineCallback(x0, y0, x1, y1, colour);
+		return;
+	}
+	if (line_count == line_buffer_cap)
+		l3d_flushLines();
+	line_buffer[line_count++] = (l3d_line_t){ x0, y0, x1, y1, colour };
+#else
+	l3d_drawLineCallback(x0, y0, x1, y1, colour);
+#endif
+}
+
+#ifdef USE_FILLED_MESHES
+// 
+// Pass a horizontal span in screen coordinates on to the output:
+// the framebuffer or l3d_drawSpanCallback().
+// 
+static void submitSpan(int32_t y, int32_t x0, int32_t x1, l3d_colour_t colour) {
+#ifdef L3D_USE_FRAMEBUFFER
+	l3d_framebuffer_drawSpan(y, x0, x1, colour);
+#else
+	l3d_drawSpanCallback(y, x0, x1, colour);
+#endif
+}
+
+// 
+// Fill triangle given in integer screen coordinates, scanline by scanline.
+// Edges are walked in 16.16 fixed point. Scanlines from the top vertex
+// up to (excluding) the bottom one are filled, and each span covers
+// pixels from the left edge up to (excluding) the right one,
+// so triangles sharing an edge do not overlap.
+// Spans are limited to the screen.
+// 
+static void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, l3d_colour_t colour) {
+	int32_t tmp;
+	// Sort vertices by y
+	if (y1 < y0) {
+		tmp = x0; x0 = x1; x1 = tmp;
+		tmp = y0; y0 = y1; y1 = tmp;
+	}
+	if (y2 < y0) {
+		tmp = x0; x0 = x2; x2 = tmp;
+		tmp = y0; y0 = y2; y2 = tmp;
+	}
+	if (y2 < y1) {
+		tmp = x1; x1 = x2; x2 = tmp;
+		tmp = y1; y1 = y2; y2 = tmp;
+	}
+	if (y0 == y2)
+		return;
+
+	// The long edge spans the whole triangle, the short ones meet at vertex 1
+	l3d_fxp2_t slope_long = ((l3d_fxp2_t)(x2 - x0) << 16) / (y2 - y0);
+	l3d_fxp2_t slope_top = y1 > y0 ? ((l3d_fxp2_t)(x1 - x0) << 16) / (y1 - y0) : 0;
+	l3d_fxp2_t slope_bottom = y2 > y1 ? ((l3d_fxp2_t)(x2 - x1) << 16) / (y2 - y1) : 0;
+
+	int32_t y_start = y0 > 0 ? y0 : 0;
+	int32_t y_end = y2 < SCREEN_HEIGHT ? y2 : SCREEN_HEIGHT;
+
+	l3d_fxp2_t x_long = ((l3d_fxp2_t)x0 << 16) + slope_long * (y_start - y0);
+	l3d_fxp2_t x_short = y_start < y1 ?
+		((l3d_fxp2_t)x0 << 16) + slope_top * (y_start - y0) :
+		((l3d_fxp2_t)x1 << 16) + slope_bottom * (y_start - y1);
+
+	for (int32_t y = y_start; y < y_end; y++) {
+		if (y == y1)
+			x_short = (l3d_fxp2_t)x1 << 16;
+
+		l3d_fxp2_t x_left = x_long < x_short ? x_long : x_short;
+		l3d_fxp2_t x_right = x_long < x_short ? x_short : x_long;
+		// Round both up to whole pixels
+		l3d_fxp2_t x_first = (x_left + 0xFFFF) >> 16;
+		l3d_fxp2_t x_last = ((x_right + 0xFFFF) >> 16) - 1;
+		if (x_first < 0)
+			x_first = 0;
+		if (x_last >= SCREEN_WIDTH)
+			x_last = SCREEN_WIDTH - 1;
+		if (x_first <= x_last)
+			submitSpan(y, (int32_t)x_first, (int32_t)x_last, colour);
+
+		x_long += slope_long;
+		x_short += y < y1 ? slope_top : slope_bottom;
+	}
+}
+#endif	// USE_FILLED_MESHES
+
+#if defined(REMOVE_HIDDEN_LINES) || defined(REMOVE_HIDDEN_LINES_ANALYTIC)
+// 
+// Convert depth of a projected vertex to the depth buffer's format
+// 
+static l3d_depth_t rationalToDepth(l3d_rtnl_t z) {
+	if (z <= l3d_floatToRational(0.0f))
+		return 0;
+	if (z >= l3d_floatToRational(1.0f))
+		return L3D_DEPTH_FAR;
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+	return (l3d_depth_t)(((l3d_fxp2_t)z << 16) >> L3D_FP_DP);
+#else
+	return (l3d_depth_t)(z * (l3d_flp_t)L3D_DEPTH_FAR);
+#endif
+}
+#endif	// REMOVE_HIDDEN_LINES || REMOVE_HIDDEN_LINES_ANALYTIC
+
+#ifdef REMOVE_HIDDEN_LINES
+
+// 
+// Clip line to the screen like l3d_clipLineToRect(),
+// interpolating depth of the moved endpoints.
+// 
+static bool clipLineToScreenWithDepth(int32_t *x0, int32_t *y0, l3d_depth_t *z0, int32_t *x1, int32_t *y1, l3d_depth_t *z1) {
+	const l3d_rect_t screen = { 0, 0, SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1 };
+	int32_t x_start = *x0, y_start = *y0;
+	int32_t dx = *x1 - *x0, dy = *y1 - *y0;
+	l3d_fxp2_t dz = (l3d_fxp2_t)*z1 - *z0;
+	l3d_depth_t z_start = *z0;
+
+	if (!l3d_clipLineToRect(x0, y0, x1, y1, &screen))
+		return false;
+
+	// Depth is affine along the line on the screen;
+	// measure the endpoints along its major axis
+	bool major_x = (dx < 0 ? -dx : dx) >= (dy < 0 ? -dy : dy);
+	int32_t len = major_x ? dx : dy;
+	if (len == 0)
+		return true;
+	*z0 = (l3d_depth_t)(z_start + dz * (major_x ? *x0 - x_start : *y0 - y_start) / len);
+	*z1 = (l3d_depth_t)(z_start + dz * (major_x ? *x1 - x_start : *y1 - y_start) / len);
+	return true;
+}
+
+// 
+// Rasterise depth of all triangles of a single 3D object.
+// Triangles crossing the near plane are skipped.
+// 
+static void drawObjectDepth(const l3d_scene_t *scene, uint16_t obj_id) {
+	if (scene->model_tri_data == NULL)
+		return;
+
+	const l3d_mesh_t *mesh = &L3D_OBJ_MESH(scene, obj_id);
+	l3d_index_t tri_data_offset = mesh->model_tri_data_offset;
+	l3d_index_t tr_vert_offset = mesh->transformed_vertices_offset;
+
+	for (l3d_index_t tri_id = 0; tri_id < mesh->tri_count; tri_id++) {
+		const l3d_index_t *tri = &scene->model_tri_data[tri_data_offset + tri_id * 3];
+		const l3d_vec4_t *v0 = &scene->vertices_projected[tr_vert_offset + tri[0]];
+		const l3d_vec4_t *v1 = &scene->vertices_projected[tr_vert_offset + tri[1]];
+		const l3d_vec4_t *v2 = &scene->vertices_projected[tr_vert_offset + tri[2]];
+
+		if (!isVertexProjected(v0) || !isVertexProjected(v1) || !isVertexProjected(v2))
+			continue;
+
+		l3d_depthbuffer_drawTriangle(
+			l3d_rationalToInt32(v0->x), l3d_rationalToInt32(v0->y), rationalToDepth(v0->z),
+			l3d_rationalToInt32(v1->x), l3d_rationalToInt32(v1->y), rationalToDepth(v1->z),
+			l3d_rationalToInt32(v2->x), l3d_rationalToInt32(v2->y), rationalToDepth(v2->z));
+	}
+}
+#endif	// REMOVE_HIDDEN_LINES
+
+// 
+// Draw line between two vertices processed by l3d_clipSpaceToScreenSpace().
+// If one of them lies behind the near plane, the line is clipped
+// against it in clip space and the intersection is projected instead.
+// Lines lying entirely behind the near plane are not drawn.
+// With L3D_USE_SCREEN_CLIPPING the line is then clipped
+// to the screen rectangle.
+// With REMOVE_HIDDEN_LINES it is always clipped to the screen,
+// and only its fragments passing the depth test are drawn.
+// 
+static void drawClippedLine(const l3d_vec4_t *v1, const l3d_vec4_t *v2, l3d_colour_t colour) {
+	bool v1_projected = isVertexProjected(v1);
+	bool v2_projected = isVertexProjected(v2);
+
+	if (!v1_projected && !v2_projected)
+		return;
+
+	l3d_vec4_t a = *v1;
+	l3d_vec4_t b = *v2;
+
+	if (!v1_projected || !v2_projected) {
+		// Near plane in clip space: z >= 0
+		const l3d_plane_t near_plane = {
+			l3d_floatToRational(0.0f), l3d_floatToRational(0.0f),
+			l3d_floatToRational(1.0f), l3d_floatToRational(0.0f)
+		};
+		l3d_vec4_t *clipped = v1_projected ? &b : &a;
+		l3d_vec4_t *kept = v1_projected ? &a : &b;
+		l3d_vec4_t kept_clip = screenSpaceToClipSpace(kept);
+
+		*clipped = l3d_intersect_plane(&near_plane, &kept_clip, clipped);
+		// Rounding errors must not push it behind the plane again
+		clipped->z = l3d_floatToRational(0.0f);
+		if (!l3d_clipSpaceToScreenSpace(clipped))
+			return;
+	}
+
+	int32_t x0 = l3d_rationalToInt32(a.x);
+	int32_t y0 = l3d_rationalToInt32(a.y);
+	int32_t x1 = l3d_rationalToInt32(b.x);
+	int32_t y1 = l3d_rationalToInt32(b.y);
+
+#ifdef REMOVE_HIDDEN_LINES
+	l3d_depth_t z0 = rationalToDepth(a.z);
+	l3d_depth_t z1 = rationalToDepth(b.z);
+	if (!clipLineToScreenWithDepth(&x0, &y0, &z0, &x1, &y1, &z1))
+		return;
+	l3d_depthbuffer_drawLine(x0, y0, z0, x1, y1, z1, colour, submitLine);
+#else
+#ifdef L3D_USE_SCREEN_CLIPPING
+	// Do not pass invisible pixels to the display driver
+	const l3d_rect_t screen = { 0, 0, SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1 };
+	if (!l3d_clipLineToRect(&x0, &y0, &x1, &y1, &screen))
+		return;
+#endif
+
+	submitLine(x0, y0, x1, y1, colour);
+#endif	// REMOVE_HIDDEN_LINES
+}
+
+#ifdef REMOVE_HIDDEN_LINES_ANALYTIC
+// 
+// Analytical hidden line removal.
+// Every edge is tested against every front-facing triangle
+// of every drawn object on the screen: the part of the edge covered
+// by the triangle and lying behind its plane is hidden.
+// Hidden parts are kept as ranges of the edge's parameter t
+// (16.16 fixed point, 0 at the first vertex, 1 at the second one),
+// and only what is left of the edge is drawn.
+// No buffer of the screen's size is needed.
+// Objects and triangles whose screen bounding box misses the edge's one
+// are rejected before any other test.
+// 
+
+#define HLR_T_ONE (1 << 16)
+// How many times an edge with more than L3D_HLR_MAX_HIDDEN_RANGES
+// hidden parts is halved before it is drawn in full
+#define HLR_MAX_EDGE_SPLITS 3
+
+// Projected vertex in integer screen coordinates with depth
+typedef struct {
+	int32_t x;
+	int32_t y;
+	int32_t z;
+} l3d_screen_vert_t;
+
+static l3d_screen_vert_t toScreenVert(const l3d_vec4_t *v) {
+	return (l3d_screen_vert_t){
+		l3d_rationalToInt32(v->x),
+		l3d_rationalToInt32(v->y),
+		rationalToDepth(v->z)
+	};
+}
+
+// 
+// Narrow range [t_min, t_max] of the edge's parameter
+// to where f(t) = f0 + (f1 - f0) * t is not negative.
+// Returns false if the range becomes empty.
+// 
+static bool clipRangeToHalfPlane(l3d_fxp2_t f0, l3d_fxp2_t f1, int32_t *t_min, int32_t *t_max) {
+	if (f0 < 0 && f1 < 0)
+		return false;
+	if (f0 >= 0 && f1 >= 0)
+		return true;
+
+	int32_t t = (int32_t)((f0 << 16) / (f0 - f1));
+	if (f0 < 0) {
+		if (t > *t_min)
+			*t_min = t;
+	}
+	else if (t < *t_max)
+		*t_max = t;
+
+	return *t_min < *t_max;
+}
+
+// 
+// Find range of edge ab hidden by triangle p.
+// Returns false if the triangle hides no part of the edge.
+// 
+static bool getHiddenRange(const l3d_screen_vert_t *a, const l3d_screen_vert_t *b, const l3d_screen_vert_t p[3], int32_t *t_min, int32_t *t_max) {
+	l3d_fxp2_t area = (l3d_fxp2_t)(p[1].x - p[0].x) * (p[2].y - p[0].y) - (l3d_fxp2_t)(p[2].x - p[0].x) * (p[1].y - p[0].y);
+	if (area == 0)
+		return false;
+
+	*t_min = 0;
+	*t_max = HLR_T_ONE;
+
+	// Inside the triangle each edge function has the sign of its area
+	for (uint8_t i = 0; i < 3; i++) {
+		const l3d_screen_vert_t *p1 = &p[i];
+		const l3d_screen_vert_t *p2 = &p[(i + 1) % 3];
+		l3d_fxp2_t fa = (l3d_fxp2_t)(p2->x - p1->x) * (a->y - p1->y) - (l3d_fxp2_t)(p2->y - p1->y) * (a->x - p1->x);
+		l3d_fxp2_t fb = (l3d_fxp2_t)(p2->x - p1->x) * (b->y - p1->y) - (l3d_fxp2_t)(p2->y - p1->y) * (b->x - p1->x);
+		if (area < 0) {
+			fa = -fa;
+			fb = -fb;
+		}
+		if (!clipRangeToHalfPlane(fa, fb, t_min, t_max))
+			return false;
+	}
+
+	// Depth is affine in screen space, both along the edge and over the triangle,
+	// so the edge is behind the triangle's plane on one side of a single point
+	l3d_fxp2_t dz_dx = (((l3d_fxp2_t)(p[1].z - p[0].z) * (p[2].y - p[0].y) - (l3d_fxp2_t)(p[2].z - p[0].z) * (p[1].y - p[0].y)) << 16) / area;
+	l3d_fxp2_t dz_dy = (((l3d_fxp2_t)(p[2].z - p[0].z) * (p[1].x - p[0].x) - (l3d_fxp2_t)(p[1].z - p[0].z) * (p[2].x - p[0].x)) << 16) / area;
+	l3d_fxp2_t za = ((l3d_fxp2_t)p[0].z << 16) + dz_dx * (a->x - p[0].x) + dz_dy * (a->y - p[0].y);
+	l3d_fxp2_t zb = ((l3d_fxp2_t)p[0].z << 16) + dz_dx * (b->x - p[0].x) + dz_dy * (b->y - p[0].y);
+	l3d_fxp2_t bias = (l3d_fxp2_t)L3D_DEPTH_BIAS << 16;
+
+	return clipRangeToHalfPlane(((l3d_fxp2_t)a->z << 16) - za - bias, ((l3d_fxp2_t)b->z << 16) - zb - bias, t_min, t_max);
+}
+
+// 
+// Add range [t_min, t_max] to the sorted list of disjoint hidden ranges,
+// merging it with the ranges it overlaps.
+// Returns false if the list is full and the range overlaps none of them.
+// 
+static bool addHiddenRange(int32_t ranges[][2], uint8_t *count, int32_t t_min, int32_t t_max) {
+	uint8_t first = 0;
+	while (first < *count && ranges[first][1] < t_min)
+		first++;
+	uint8_t last = first;
+	while (last < *count && ranges[last][0] <= t_max)
+		last++;
+
+	if (first == last) {
+		if (*count < L3D_HLR_MAX_HIDDEN_RANGES) {
+			for (uint8_t i = *count; i > first; i--) {
+				ranges[i][0] = ranges[i-1][0];
+				ranges[i][1] = ranges[i-1][1];
+			}
+			ranges[first][0] = t_min;
+			ranges[first][1] = t_max;
+			(*count)++;
+			return true;
+		}
+		return false;
+	}
+
+	// Replace ranges [first, last) with their union
+	if (ranges[first][0] < t_min)
+		t_min = ranges[first][0];
+	if (ranges[last-1][1] > t_max)
+		t_max = ranges[last-1][1];
+	ranges[first][0] = t_min;
+	ranges[first][1] = t_max;
+
+	uint8_t removed = last - first - 1;
+	for (uint8_t i = first + 1; i + removed < *count; i++) {
+		ranges[i][0] = ranges[i+removed][0];
+		ranges[i][1] = ranges[i+removed][1];
+	}
+	*count -= removed;
+	return true;
+}
+
+// 
+// Point of edge ab at parameter t (16.16 fixed point)
+// 
+static l3d_vec4_t lerpProjected(const l3d_vec4_t *a, const l3d_vec4_t *b, int32_t t) {
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+	return (l3d_vec4_t){
+		a->x + (l3d_rtnl_t)(((l3d_fxp2_t)(b->x - a->x) * t) >> 16),
+		a->y + (l3d_rtnl_t)(((l3d_fxp2_t)(b->y - a->y) * t) >> 16),
+		a->z + (l3d_rtnl_t)(((l3d_fxp2_t)(b->z - a->z) * t) >> 16),
+		a->h + (l3d_rtnl_t)(((l3d_fxp2_t)(b->h - a->h) * t) >> 16)
+	};
+#else
+	l3d_flp_t k = (l3d_flp_t)t / (l3d_flp_t)HLR_T_ONE;
+	return (l3d_vec4_t){
+		a->x + (b->x - a->x) * k,
+		a->y + (b->y - a->y) * k,
+		a->z + (b->z - a->z) * k,
+		a->h + (b->h - a->h) * k
+	};
+#endif
+}
+
+// 
+// Draw visible parts of edge v1v2 of given object.
+// edge_data_idx - index of the edge in model_edge_data
+// splits_left - how many more times the edge may be halved
+// when it has too many hidden parts
+// 
+static void drawVisibleEdgeParts(const l3d_scene_t *scene, uint16_t obj_id, l3d_index_t edge_data_idx, const l3d_vec4_t *v1, const l3d_vec4_t *v2, l3d_colour_t colour, uint8_t splits_left) {
+	// Edges crossing the near plane are drawn as they are
+	if (!isVertexProjected(v1) || !isVertexProjected(v2)) {
+		drawClippedLine(v1, v2, colour);
+		return;
+	}
+
+	l3d_screen_vert_t a = toScreenVert(v1);
+	l3d_screen_vert_t b = toScreenVert(v2);
+	l3d_rect_t edge_box = {
+		a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y,
+		a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y
+	};
+	l3d_index_t face1_id = scene->model_edge_data[edge_data_idx + 2];
+	l3d_index_t face2_id = scene->model_edge_data[edge_data_idx + 3];
+
+	int32_t hidden[L3D_HLR_MAX_HIDDEN_RANGES][2];
+	uint8_t hidden_count = 0;
+
+	for (uint16_t occ_id = 0; occ_id < scene->object_count; occ_id++) {
+		if (!L3D_OBJ_VISIBLE(scene, occ_id))
+			continue;
+#ifdef L3D_USE_FRUSTUM_CULLING
+		if (!L3D_OBJ_IN_VIEW(scene, occ_id))
+			continue;
+#endif
+		if (!rectsOverlap(&edge_box, &L3D_OBJ_SCREEN_RECT(scene, occ_id)))
+			continue;
+
+		const l3d_mesh_t *occ = &L3D_OBJ_MESH(scene, occ_id);
+		const uint8_t *tri_flags = &scene->tri_flags[occ->tris_flags_offset];
+		l3d_index_t tri_data_offset = occ->model_tri_data_offset;
+		l3d_index_t tr_vert_offset = occ->transformed_vertices_offset;
+
+		for (l3d_index_t tri_id = 0; tri_id < occ->tri_count; tri_id++) {
+			// Back faces are hidden by front faces anyway,
+			// and an edge is never hidden by its own faces
+			if (!L3D_IS_TRI_VISIBLE(tri_flags[tri_id]))
+				continue;
+			if (occ_id == obj_id && (tri_id == face1_id || tri_id == face2_id))
+				continue;
+
+			const l3d_index_t *tri = &scene->model_tri_data[tri_data_offset + tri_id * 3];
+			const l3d_vec4_t *pv[3] = {
+				&scene->vertices_projected[tr_vert_offset + tri[0]],
+				&scene->vertices_projected[tr_vert_offset + tri[1]],
+				&scene->vertices_projected[tr_vert_offset + tri[2]]
+			};
+			if (!isVertexProjected(pv[0]) || !isVertexProjected(pv[1]) || !isVertexProjected(pv[2]))
+				continue;
+
+			l3d_screen_vert_t p[3] = { toScreenVert(pv[0]), toScreenVert(pv[1]), toScreenVert(pv[2]) };
+
+			// Cheap rejection by bounding boxes
+			if ((p[0].x < edge_box.x_min && p[1].x < edge_box.x_min && p[2].x < edge_box.x_min) ||
+				(p[0].x > edge_box.x_max && p[1].x > edge_box.x_max && p[2].x > edge_box.x_max) ||
+				(p[0].y < edge_box.y_min && p[1].y < edge_box.y_min && p[2].y < edge_box.y_min) ||
+				(p[0].y > edge_box.y_max && p[1].y > edge_box.y_max && p[2].y > edge_box.y_max))
+				continue;
+
+			int32_t t_min, t_max;
+			if (!getHiddenRange(&a, &b, p, &t_min, &t_max))
+				continue;
+
+			if (!addHiddenRange(hidden, &hidden_count, t_min, t_max)) {
+				// Merging ranges would hide visible parts between them,
+				// so each half of the edge is processed on its own instead.
+				// Showing a hidden part is the lesser evil once the edge
+				// can not be halved any more.
+				if (splits_left == 0) {
+					drawClippedLine(v1, v2, colour);
+					return;
+				}
+				l3d_vec4_t mid = lerpProjected(v1, v2, HLR_T_ONE / 2);
+				drawVisibleEdgeParts(scene, obj_id, edge_data_idx, v1, &mid, colour, splits_left - 1);
+				drawVisibleEdgeParts(scene, obj_id, edge_data_idx, &mid, v2, colour, splits_left - 1);
+				return;
+			}
+
+			// Nothing left to draw
+			if (hidden_count == 1 && hidden[0][0] == 0 && hidden[0][1] == HLR_T_ONE)
+				return;
+		}
+	}
+
+	// Draw what is left between the hidden ranges
+	int32_t t_start = 0;
+	for (uint8_t i = 0; i <= hidden_count; i++) {
+		int32_t t_end = i < hidden_count ? hidden[i][0] : HLR_T_ONE;
+		if (t_end > t_start) {
+			l3d_vec4_t start = lerpProjected(v1, v2, t_start);
+			l3d_vec4_t end = lerpProjected(v1, v2, t_end);
+			drawClippedLine(&start, &end, colour);
+		}
+		if (i < hidden_count)
+			t_start = hidden[i][1];
+	}
+}
+#endif	// REMOVE_HIDDEN_LINES_ANALYTIC
+
+// 
+// Draw a single edge of given object,
+// leaving out its hidden parts with REMOVE_HIDDEN_LINES_ANALYTIC.
+// 
+static void drawEdge(const l3d_scene_t *scene, uint16_t obj_id, l3d_index_t edge_data_idx, const l3d_vec4_t *v1, const l3d_vec4_t *v2, l3d_colour_t colour) {
+#ifdef REMOVE_HIDDEN_LINES_ANALYTIC
+	drawVisibleEdgeParts(scene, obj_id, edge_data_idx, v1, v2, colour, HLR_MAX_EDGE_SPLITS);
+#else
+	(void)scene;
+	(void)obj_id;
+	(void)edge_data_idx;
+	drawClippedLine(v1, v2, colour);
+#endif
+}
+
 // 
 // Draw wireframe of a signle 3D object
 // 
 l3d_err_t l3d_drawWireframe(const l3d_scene_t *scene, uint16_t obj_id) {
-	l3d_obj3d_t *obj3d = &(scene->objects[obj_id]);
-	if (obj3d == NULL)
+	if (obj_id >= scene->object_count)
 		return L3D_DATA_EMPTY;
 
-	uint16_t edge_data_offset = obj3d->mesh.model_edge_data_offset;// * 3;
+	const l3d_mesh_t *mesh = &L3D_OBJ_MESH(scene, obj_id);
+	l3d_index_t edge_data_offset = mesh->model_edge_data_offset;
+	l3d_index_t edge_flags_offset = mesh->edges_flags_offset;
 
-	// L3D_DEBUG_PRINT("obj idx: %d, obj3d->mesh.model_edge_data_offset = %d, edge_data_offset = %d\n",
-	// 	obj_id, obj3d->mesh.model_edge_data_offset, edge_data_offset);
+	// L3D_DEBUG_PRINT("obj idx: %d, mesh->model_edge_data_offset = %d, edge_data_offset = %d\n",
+	// 	obj_id, mesh->model_edge_data_offset, edge_data_offset);
 
-	// This draws all the edges of all meshes
-	// for (uint16_t edge_data_idx = edge_data_offset; edge_data_idx < edge_data_offset + scene->model_edge_count * 3; edge_data_idx += 3) {
-	
 	// For each edge of the object's mesh
-	for (uint16_t edge_data_idx = edge_data_offset; edge_data_idx < edge_data_offset + obj3d->mesh.edge_count * 3; edge_data_idx += 3) {
-		// If edge invisible: continue
-		uint16_t edge_id = edge_data_idx/3;
+	for (l3d_index_t edge_id = 0; edge_id < mesh->edge_count; edge_id++) {
+		l3d_index_t edge_data_idx = edge_data_offset + edge_id * L3D_EDGE_DATA_STRIDE;
 
 		// L3D_DEBUG_PRINT("obj idx: %d: edge_data_idx = %d, edge_id = %d\n",
 		// 	obj_id, edge_data_idx, edge_id);
 		
-		uint8_t flags = scene->edge_flags[edge_id];
+		// Edge flags are stored per instance
+		uint8_t flags = scene->edge_flags[edge_flags_offset + edge_id];
 		if (!L3D_IS_EDGE_VISISBLE(flags))
 			continue;
+#ifdef DRAW_CONTOUR_ONLY
+		if (!L3D_IS_EDGE_SILHOUETTE(flags))
+			continue;
+#endif
 		
 		// set to zero when only multiple instances
 		// set to transformed_vertices_offset when many meshes each with a single instance
-		uint16_t tr_vert_offset = obj3d->mesh.transformed_vertices_offset;
+		l3d_index_t tr_vert_offset = mesh->transformed_vertices_offset;
 
 		// Get projected vertices
-		uint16_t v1_id = scene->model_edge_data[edge_data_idx+0] + tr_vert_offset;// + obj3d->mesh.model_vert_data_offset/3;
-		uint16_t v2_id = scene->model_edge_data[edge_data_idx+1] + tr_vert_offset;// + obj3d->mesh.model_vert_data_offset/3;
-		// uint16_t tri_id = scene->model_edge_data[edge_id+2];
+		l3d_index_t v1_id = scene->model_edge_data[edge_data_idx+0] + tr_vert_offset;// + mesh->model_vert_data_offset/3;
+		l3d_index_t v2_id = scene->model_edge_data[edge_data_idx+1] + tr_vert_offset;// + mesh->model_vert_data_offset/3;
 
-		// L3D_DEBUG_PRINT("obj idx: %d: model_vert_data_offset = %d, obj3d->mesh.transformed_vertices_offset = %d\n",
-		// 	obj_id, obj3d->mesh.model_vert_data_offset, obj3d->mesh.transformed_vertices_offset);
+		// L3D_DEBUG_PRINT("obj idx: %d: model_vert_data_offset = %d, mesh->transformed_vertices_offset = %d\n",
+		// 	obj_id, mesh->model_vert_data_offset, mesh->transformed_vertices_offset);
 
 		// L3D_DEBUG_PRINT("obj idx: %d: vm1_id = %d, vm2_id = %d\n",
 		// 	obj_id, v1_id, v2_id);
@@ -291,42 +1284,34 @@ l3d_err_t l3d_drawWireframe(const l3d_scene_t *scene, uint16_t obj_id) {
 		// L3D_DEBUG_PRINT("obj idx: %d: vp1_id = %d, vp2_id = %d\n",
 		// 	obj_id, v1_id, v2_id);
 
-		l3d_vec4_t v1 = scene->vertices_projected[v1_id];
-		l3d_vec4_t v2 = scene->vertices_projected[v2_id];
+		l3d_vec4_t v1 = getProjectedVertex(scene, v1_id);
+		l3d_vec4_t v2 = getProjectedVertex(scene, v2_id);
+#ifdef L3D_USE_SOA_VERTICES
+		// Clipping against the near plane needs clip space w of both vertices
+		if (!isVertexProjected(&v1) || !isVertexProjected(&v2)) {
+			v1 = projectWorldVertex(scene, v1_id);
+			v2 = projectWorldVertex(scene, v2_id);
+		}
+#endif
 
 		// Draw the edge
 #ifdef L3D_DEBUG_EDGES
 		if (L3D_IS_EDGE_BOUNDARY(flags))
-			l3d_drawLineCallback(
-				l3d_rationalToInt32(v1.x), l3d_rationalToInt32(v1.y),
-				l3d_rationalToInt32(v2.x), l3d_rationalToInt32(v2.y),
-				L3D_DEBUG_BOUNDARY_EDGE_COLOUR);
+			drawEdge(scene, obj_id, edge_data_idx, &v1, &v2, L3D_DEBUG_BOUNDARY_EDGE_COLOUR);
 		else if (L3D_IS_EDGE_SILHOUETTE(flags))
-			l3d_drawLineCallback(
-				l3d_rationalToInt32(v1.x), l3d_rationalToInt32(v1.y),
-				l3d_rationalToInt32(v2.x), l3d_rationalToInt32(v2.y),
-				L3D_DEBUG_SILHOUETTE_EDGE_COLOUR);
+			drawEdge(scene, obj_id, edge_data_idx, &v1, &v2, L3D_DEBUG_SILHOUETTE_EDGE_COLOUR);
 #ifdef L3D_DRAW_INNER_EDGES
 		else
-			l3d_drawLineCallback(
-				l3d_rationalToInt32(v1.x), l3d_rationalToInt32(v1.y),
-				l3d_rationalToInt32(v2.x), l3d_rationalToInt32(v2.y),
-				L3D_DEBUG_VISIBLE_EDGE_COLOUR);
+			drawEdge(scene, obj_id, edge_data_idx, &v1, &v2, L3D_DEBUG_VISIBLE_EDGE_COLOUR);
 #endif	// L3D_DRAW_INNER_EDGES
 #else
 #ifdef L3D_DRAW_INNER_EDGES
 	// Draw all edges
-	l3d_drawLineCallback(
-		l3d_rationalToInt32(v1.x), l3d_rationalToInt32(v1.y),
-		l3d_rationalToInt32(v2.x), l3d_rationalToInt32(v2.y),
-		obj3d->wireframe_colour);
+	drawEdge(scene, obj_id, edge_data_idx, &v1, &v2, L3D_OBJ_WIREFRAME_COLOUR(scene, obj_id));
 #else
 	// Draw only boundary edges
 	if (L3D_IS_EDGE_BOUNDARY(flags)) {
-		l3d_drawLineCallback(
-			l3d_rationalToInt32(v1.x), l3d_rationalToInt32(v1.y),
-			l3d_rationalToInt32(v2.x), l3d_rationalToInt32(v2.y),
-			obj3d->wireframe_colour);
+		drawEdge(scene, obj_id, edge_data_idx, &v1, &v2, L3D_OBJ_WIREFRAME_COLOUR(scene, obj_id));
 	}
 #endif	// L3D_DRAW_INNER_EDGES
 #endif	// L3D_DEBUG_EDGES
@@ -335,50 +1320,82 @@ l3d_err_t l3d_drawWireframe(const l3d_scene_t *scene, uint16_t obj_id) {
 	return L3D_OK;
 }
 
+#ifdef USE_FILLED_MESHES
+// 
+// Fill triangles of a single 3D object with its fill_colour.
+// Triangles facing away from the camera (judged by the winding
+// of their projected vertices) and triangles crossing the near plane
+// are skipped.
+// Triangles are neither sorted nor depth-tested, so the result is only
+// correct for a single convex object, or for objects that do not overlap
+// on the screen. Edges are drawn only if one of their faces faces
+// the camera (see updateFaceVisibility()).
+// 
+l3d_err_t l3d_drawFilledMesh(const l3d_scene_t *scene, uint16_t obj_id) {
+	if (obj_id >= scene->object_count || scene->model_tri_data == NULL)
+		return L3D_DATA_EMPTY;
+
+	const l3d_mesh_t *mesh = &L3D_OBJ_MESH(scene, obj_id);
+	l3d_index_t tri_data_offset = mesh->model_tri_data_offset;
+	l3d_index_t tr_vert_offset = mesh->transformed_vertices_offset;
+
+	for (l3d_index_t tri_id = 0; tri_id < mesh->tri_count; tri_id++) {
+		const l3d_index_t *tri = &scene->model_tri_data[tri_data_offset + tri_id * 3];
+		l3d_vec4_t vertices[3] = {
+			getProjectedVertex(scene, tr_vert_offset + tri[0]),
+			getProjectedVertex(scene, tr_vert_offset + tri[1]),
+			getProjectedVertex(scene, tr_vert_offset + tri[2])
+		};
+		const l3d_vec4_t *v0 = &vertices[0];
+		const l3d_vec4_t *v1 = &vertices[1];
+		const l3d_vec4_t *v2 = &vertices[2];
+
+		if (!isVertexProjected(v0) || !isVertexProjected(v1) || !isVertexProjected(v2))
+			continue;
+
+		int32_t x0 = l3d_rationalToInt32(v0->x), y0 = l3d_rationalToInt32(v0->y);
+		int32_t x1 = l3d_rationalToInt32(v1->x), y1 = l3d_rationalToInt32(v1->y);
+		int32_t x2 = l3d_rationalToInt32(v2->x), y2 = l3d_rationalToInt32(v2->y);
+
+		// Twice the signed area of the triangle on the screen;
+		// front faces end up with negative area
+		int64_t area = (int64_t)(x1 - x0) * (y2 - y0) - (int64_t)(x2 - x0) * (y1 - y0);
+		if (area >= 0)
+			continue;
+
+		fillTriangle(x0, y0, x1, y1, x2, y2, L3D_OBJ_FILL_COLOUR(scene, obj_id));
+	}
+
+	return L3D_OK;
+}
+#endif	// USE_FILLED_MESHES
+
 // 
 // Draw gizmos of given object.
 // For now, only its location marker.
 // 
 l3d_err_t l3d_drawGizmos(const l3d_scene_t *scene, uint16_t obj_id) {
-	l3d_obj3d_t *obj3d = &(scene->objects[obj_id]);
-	if (obj3d == NULL)
+	if (obj_id >= scene->object_count)
 		return L3D_DATA_EMPTY;
 
+	const l3d_vec4_t *u_proj = L3D_OBJ_U_PROJ(scene, obj_id);
 	// X
-	l3d_drawLineCallback(
-		l3d_rationalToInt32(obj3d->u_proj[1].x), l3d_rationalToInt32(obj3d->u_proj[1].y),
-		l3d_rationalToInt32(obj3d->u_proj[0].x), l3d_rationalToInt32(obj3d->u_proj[0].y),
-		L3D_COLOUR_RED);
+	drawClippedLine(&u_proj[1], &u_proj[0], L3D_COLOUR_RED);
 	// Y
-	l3d_drawLineCallback(
-		l3d_rationalToInt32(obj3d->u_proj[2].x), l3d_rationalToInt32(obj3d->u_proj[2].y),
-		l3d_rationalToInt32(obj3d->u_proj[0].x), l3d_rationalToInt32(obj3d->u_proj[0].y),
-		L3D_COLOUR_GREEN);
+	drawClippedLine(&u_proj[2], &u_proj[0], L3D_COLOUR_GREEN);
 	// Z
-	l3d_drawLineCallback(
-		l3d_rationalToInt32(obj3d->u_proj[3].x), l3d_rationalToInt32(obj3d->u_proj[3].y),
-		l3d_rationalToInt32(obj3d->u_proj[0].x), l3d_rationalToInt32(obj3d->u_proj[0].y),
-		L3D_COLOUR_BLUE);
+	drawClippedLine(&u_proj[3], &u_proj[0], L3D_COLOUR_BLUE);
 	
 	return L3D_OK;
 }
 
 l3d_err_t l3d_drawGlobalAxesMarker(void) {
 	// X
-	l3d_drawLineCallback(
-		l3d_rationalToInt32(global_axes_proj[1].x), l3d_rationalToInt32(global_axes_proj[1].y),
-		l3d_rationalToInt32(global_axes_proj[0].x), l3d_rationalToInt32(global_axes_proj[0].y),
-		L3D_COLOUR_DARKRED);
+	drawClippedLine(&global_axes_proj[1], &global_axes_proj[0], L3D_COLOUR_DARKRED);
 	// Y
-	l3d_drawLineCallback(
-		l3d_rationalToInt32(global_axes_proj[2].x), l3d_rationalToInt32(global_axes_proj[2].y),
-		l3d_rationalToInt32(global_axes_proj[0].x), l3d_rationalToInt32(global_axes_proj[0].y),
-		L3D_COLOUR_DARKGREEN);
+	drawClippedLine(&global_axes_proj[2], &global_axes_proj[0], L3D_COLOUR_DARKGREEN);
 	// Z
-	l3d_drawLineCallback(
-		l3d_rationalToInt32(global_axes_proj[3].x), l3d_rationalToInt32(global_axes_proj[3].y),
-		l3d_rationalToInt32(global_axes_proj[0].x), l3d_rationalToInt32(global_axes_proj[0].y),
-		L3D_COLOUR_DARKBLUE);
+	drawClippedLine(&global_axes_proj[3], &global_axes_proj[0], L3D_COLOUR_DARKBLUE);
 	
 	return L3D_OK;
 }
@@ -388,15 +1405,53 @@ l3d_err_t l3d_drawGlobalAxesMarker(void) {
 // 
 l3d_err_t l3d_drawObjects(const l3d_scene_t *scene) {
 	if (scene == NULL ||
+#ifdef L3D_USE_SOA_OBJECTS
+		scene->object_meshes == NULL ||
+#else
 		scene->objects == NULL ||
+#endif
 		scene->edge_flags == NULL ||
 		scene->model_edge_data == NULL ||
+#ifdef L3D_USE_SOA_VERTICES
+		scene->vertices_screen_x == NULL ||
+		scene->vertices_screen_y == NULL )
+#else
 		scene->vertices_projected == NULL )
+#endif
 		return L3D_WRONG_PARAM;
 
 	l3d_err_t ret = L3D_OK;
 
+#ifdef REMOVE_HIDDEN_LINES
+	// Depth of every object has to be known before any edge is drawn
+	l3d_depthbuffer_clear();
+	for (uint16_t obj_id = 0; obj_id < scene->object_count; obj_id++) {
+		if (!L3D_OBJ_VISIBLE(scene, obj_id))
+			continue;
+#ifdef L3D_USE_FRUSTUM_CULLING
+		if (!L3D_OBJ_IN_VIEW(scene, obj_id))
+			continue;
+#endif
+		drawObjectDepth(scene, obj_id);
+	}
+#endif
+
 	for (uint16_t obj_id = 0; obj_id < scene->object_count; obj_id++) {
+		if (!L3D_OBJ_VISIBLE(scene, obj_id))
+			continue;
+#ifdef L3D_USE_FRUSTUM_CULLING
+		if (!L3D_OBJ_IN_VIEW(scene, obj_id))
+			continue;
+#endif
+
+#ifdef USE_FILLED_MESHES
+		// Edges are drawn over the faces
+		ret = l3d_drawFilledMesh(scene, obj_id);
+
+		if (ret != L3D_OK)
+			break;
+#endif
+
 		ret = l3d_drawWireframe(scene, obj_id);
 
 		if (ret != L3D_OK)
@@ -414,7 +1469,15 @@ l3d_err_t l3d_drawObjects(const l3d_scene_t *scene) {
 // 
 // Compute projection and view matrices if needed,
 // transform objects into view space,
-// and draw them
+// and draw them.
+// Only objects which have been updated since the last call
+// are projected again, unless the active camera has changed -
+// then every object has to be projected.
+// Hidden objects and objects outside the view frustum are skipped.
+// With L3D_USE_DIRTY_RECTANGLES the screen regions changed by this call
+// are available through l3d_scene_getDirtyRects() afterwards.
+// With L3D_USE_FRAMEBUFFER the scene is rendered into the framebuffer,
+// available through l3d_framebuffer_getBuffer() once this returns.
 // 
 l3d_err_t l3d_processScene(l3d_scene_t *scene) {
 	if (scene == NULL)
@@ -423,6 +1486,9 @@ l3d_err_t l3d_processScene(l3d_scene_t *scene) {
 	l3d_camera_t *cam = l3d_scene_getActiveCamera(scene);
 	// cam can not be NULL, because scene is not NULL
 
+	// Check it before the flags get cleared below
+	bool cam_changed = cam->is_modified || cam->has_moved;
+
 	// Update projection matrix if needed
 	if (cam->is_modified) {
 		l3d_makeProjectionMatrix(&(scene->mat_proj), cam);
@@ -433,10 +1499,37 @@ l3d_err_t l3d_processScene(l3d_scene_t *scene) {
 	// Update view matrix if needed
 	if (cam->has_moved) {
 		l3d_computeViewMatrix(cam, &(scene->mat_view));
+		updateObjectWorldSpace(scene, L3D_OBJ_TYPE_CAMERA, scene->active_camera_idx);
 		cam->has_moved = false;
 	}
 #endif
+
+#ifdef L3D_USE_FUSED_MVP
+	// Common part of every object's model-view-projection matrix,
+	// only depends on the camera
+	if (cam_changed)
+		l3d_mat3x4_mulMat4x4(&(scene->mat_view_proj), &(scene->mat_view), &(scene->mat_proj));
+#endif
+
+#ifdef L3D_USE_FRUSTUM_CULLING
+	if (cam_changed) {
+		l3d_rtnl_t depth_range = cam->far_plane - cam->near_plane;
+#if defined(L3D_USE_FUSED_MVP) && defined(L3D_CAMERA_MOVABLE)
+		l3d_mat4x4_getFrustumPlanes(scene->frustum_planes, &(scene->mat_view_proj), depth_range);
+#elif defined(L3D_CAMERA_MOVABLE)
+		l3d_mat4x4_t mat_view_proj;
+		l3d_mat3x4_mulMat4x4(&mat_view_proj, &(scene->mat_view), &(scene->mat_proj));
+		l3d_mat4x4_getFrustumPlanes(scene->frustum_planes, &mat_view_proj, depth_range);
+#else
+		l3d_mat4x4_getFrustumPlanes(scene->frustum_planes, &(scene->mat_proj), depth_range);
+#endif
+	}
+#endif
 	
+#ifdef L3D_USE_DIRTY_RECTANGLES
+	scene->dirty_rect_count = 0;
+#endif
+
 	l3d_err_t ret;
 	// ret = l3d_processObjects(scene, &(scene->mat_proj), &(scene->mat_view));
 
@@ -444,11 +1537,65 @@ l3d_err_t l3d_processScene(l3d_scene_t *scene) {
 	// 	return ret;
 
 	for (uint16_t obj_idx=0; obj_idx<scene->object_count; obj_idx++) {
+		// Hidden objects are skipped,
+		// but have to be processed again once shown
+		if (!L3D_OBJ_VISIBLE(scene, obj_idx)) {
+			L3D_OBJ_UPDATED(scene, obj_idx) = true;
+#ifdef L3D_USE_DIRTY_RECTANGLES
+			updateScreenRect(scene, obj_idx, false, false);
+#endif
+			continue;
+		}
+
+		// Reuse vertices projected in one of the previous frames
+		if (!cam_changed && !L3D_OBJ_UPDATED(scene, obj_idx))
+			continue;
+
+#ifdef L3D_USE_FRUSTUM_CULLING
+		// Objects out of view are neither transformed nor drawn.
+		// The updated flag is left as is, so that a pending
+		// world space update is not lost.
+		L3D_OBJ_IN_VIEW(scene, obj_idx) = isObjectInFrustum(scene, obj_idx);
+		if (!L3D_OBJ_IN_VIEW(scene, obj_idx)) {
+#ifdef L3D_USE_DIRTY_RECTANGLES
+			updateScreenRect(scene, obj_idx, false, false);
+#endif
+			continue;
+		}
+#endif
+
+#ifndef L3D_USE_FUSED_MVP
+		// Pose changed - rebuild world space vertices from the model data
+		// (the fused path reads the model data directly)
+		if (L3D_OBJ_UPDATED(scene, obj_idx))
+			updateObjectWorldSpace(scene, L3D_OBJ_TYPE_OBJ3D, obj_idx);
+#endif
+
 		l3d_transformObjectIntoViewSpace(scene, L3D_OBJ_TYPE_OBJ3D, obj_idx);
+#if defined(L3D_RENDER_VISIBLE_ONLY) || defined(DRAW_CONTOUR_ONLY) || defined(REMOVE_HIDDEN_LINES_ANALYTIC) || defined(USE_FILLED_MESHES)
+		updateFaceVisibility(scene, obj_idx);
+#endif
+#ifdef L3D_USE_DIRTY_RECTANGLES
+		updateScreenRect(scene, obj_idx, true, true);
+#elif defined(REMOVE_HIDDEN_LINES_ANALYTIC)
+		// Lets the hidden line removal skip objects away from an edge
+		L3D_OBJ_SCREEN_RECT(scene, obj_idx) = computeScreenRect(scene, obj_idx);
+#endif
+		L3D_OBJ_UPDATED(scene, obj_idx) = false;
 	}
 
+#ifdef L3D_USE_FRAMEBUFFER
+	// Every object is drawn again, not only the updated ones
+	l3d_framebuffer_clear(L3D_FRAMEBUFFER_CLEAR_COLOUR);
+#endif
+
 	ret = l3d_drawObjects(scene);
 
+#ifdef L3D_USE_LINE_BATCHING
+	// End of frame
+	l3d_flushLines();
+#endif
+
 	return ret;
 }
 
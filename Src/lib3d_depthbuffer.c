@@ -0,0 +1,175 @@
+#include "../Inc/lib3d_depthbuffer.h"
+#include "../Inc/lib3d_math.h"	// for l3d_fxp2_t
+
+#ifdef REMOVE_HIDDEN_LINES
+
+#include <stdlib.h>	// for abs()
+#include <string.h>	// for memset()
+
+static l3d_depth_t depthbuffer[SCREEN_WIDTH * SCREEN_HEIGHT];
+
+// 
+// Reset every pixel to the far plane
+// 
+void l3d_depthbuffer_clear(void) {
+	// L3D_DEPTH_FAR has all bytes equal
+	memset(depthbuffer, 0xFF, sizeof(depthbuffer));
+}
+
+// 
+// Rasterise depth of a triangle given in integer screen coordinates,
+// keeping the nearest value of each pixel.
+// Depth is affine in screen space after the perspective divide,
+// so it is interpolated with the triangle's plane equation in 16.16 fixed point.
+// Coverage follows the same rules as the filled mesh rasteriser:
+// rows from the top vertex up to (excluding) the bottom one,
+// columns from the left edge up to (excluding) the right one.
+// 
+void l3d_depthbuffer_drawTriangle(int32_t x0, int32_t y0, l3d_depth_t z0,
+								  int32_t x1, int32_t y1, l3d_depth_t z1,
+								  int32_t x2, int32_t y2, l3d_depth_t z2) {
+	int32_t tmp;
+	// Sort vertices by y
+	if (y1 < y0) {
+		tmp = x0; x0 = x1; x1 = tmp;
+		tmp = y0; y0 = y1; y1 = tmp;
+		tmp = z0; z0 = z1; z1 = tmp;
+	}
+	if (y2 < y0) {
+		tmp = x0; x0 = x2; x2 = tmp;
+		tmp = y0; y0 = y2; y2 = tmp;
+		tmp = z0; z0 = z2; z2 = tmp;
+	}
+	if (y2 < y1) {
+		tmp = x1; x1 = x2; x2 = tmp;
+		tmp = y1; y1 = y2; y2 = tmp;
+		tmp = z1; z1 = z2; z2 = tmp;
+	}
+
+	l3d_fxp2_t area = (l3d_fxp2_t)(x1 - x0) * (y2 - y0) - (l3d_fxp2_t)(x2 - x0) * (y1 - y0);
+	if (area == 0)
+		return;
+
+	// Depth gradients
+	l3d_fxp2_t dz_dx = (((l3d_fxp2_t)(z1 - z0) * (y2 - y0) - (l3d_fxp2_t)(z2 - z0) * (y1 - y0)) << 16) / area;
+	l3d_fxp2_t dz_dy = (((l3d_fxp2_t)(z2 - z0) * (x1 - x0) - (l3d_fxp2_t)(z1 - z0) * (x2 - x0)) << 16) / area;
+
+	// The long edge spans the whole triangle, the short ones meet at vertex 1
+	l3d_fxp2_t slope_long = ((l3d_fxp2_t)(x2 - x0) << 16) / (y2 - y0);
+	l3d_fxp2_t slope_top = y1 > y0 ? ((l3d_fxp2_t)(x1 - x0) << 16) / (y1 - y0) : 0;
+	l3d_fxp2_t slope_bottom = y2 > y1 ? ((l3d_fxp2_t)(x2 - x1) << 16) / (y2 - y1) : 0;
+
+	int32_t y_start = y0 > 0 ? y0 : 0;
+	int32_t y_end = y2 < SCREEN_HEIGHT ? y2 : SCREEN_HEIGHT;
+
+	l3d_fxp2_t x_long = ((l3d_fxp2_t)x0 << 16) + slope_long * (y_start - y0);
+	l3d_fxp2_t x_short = y_start < y1 ?
+		((l3d_fxp2_t)x0 << 16) + slope_top * (y_start - y0) :
+		((l3d_fxp2_t)x1 << 16) + slope_bottom * (y_start - y1);
+
+	for (int32_t y = y_start; y < y_end; y++) {
+		if (y == y1)
+			x_short = (l3d_fxp2_t)x1 << 16;
+
+		l3d_fxp2_t x_left = x_long < x_short ? x_long : x_short;
+		l3d_fxp2_t x_right = x_long < x_short ? x_short : x_long;
+		l3d_fxp2_t x_first = (x_left + 0xFFFF) >> 16;
+		l3d_fxp2_t x_last = ((x_right + 0xFFFF) >> 16) - 1;
+		if (x_first < 0)
+			x_first = 0;
+		if (x_last >= SCREEN_WIDTH)
+			x_last = SCREEN_WIDTH - 1;
+
+		if (x_first <= x_last) {
+			l3d_fxp2_t z = ((l3d_fxp2_t)z0 << 16) + dz_dx * (x_first - x0) + dz_dy * (y - y0);
+			l3d_depth_t *p = &depthbuffer[y * SCREEN_WIDTH + x_first];
+			for (l3d_fxp2_t x = x_first; x <= x_last; x++) {
+				l3d_fxp2_t d = z >> 16;
+				if (d < 0)
+					d = 0;
+				if (d < *p)
+					*p = (l3d_depth_t)d;
+				p++;
+				z += dz_dx;
+			}
+		}
+
+		x_long += slope_long;
+		x_short += y < y1 ? slope_top : slope_bottom;
+	}
+}
+
+// 
+// Depth-test every pixel of a line given in screen coordinates
+// (Bresenham's algorithm) and pass each run of visible pixels
+// to output as a separate line.
+// A pixel is visible if it is not further than L3D_DEPTH_BIAS
+// plus the line's depth change over one step behind the depth buffer,
+// so that edges are not hidden by the very triangles they belong to,
+// even where the triangles' rasterisation is a pixel off the line.
+// Runs of a single pixel are depth fighting noise rather than
+// visible parts of the edge and are dropped.
+// The line must lie on the screen.
+// 
+void l3d_depthbuffer_drawLine(int32_t x0, int32_t y0, l3d_depth_t z0,
+							  int32_t x1, int32_t y1, l3d_depth_t z1,
+							  l3d_colour_t colour, l3d_lineOutput_t output) {
+	int32_t dx = abs(x1 - x0);
+	int32_t dy = -abs(y1 - y0);
+	int32_t step_x = x0 < x1 ? 1 : -1;
+	int32_t step_y = y0 < y1 ? 1 : -1;
+	int32_t err = dx + dy;
+	int32_t steps = dx > -dy ? dx : -dy;
+
+	l3d_fxp2_t z = (l3d_fxp2_t)z0 << 16;
+	l3d_fxp2_t dz = steps ? (((l3d_fxp2_t)z1 - z0) << 16) / steps : 0;
+	l3d_fxp2_t bias = L3D_DEPTH_BIAS + ((dz < 0 ? -dz : dz) >> 16);
+
+	int32_t x = x0, y = y0;
+	int32_t run_x = 0, run_y = 0, last_x = 0, last_y = 0;
+	bool in_run = false;
+
+	while (true) {
+		bool visible = (z >> 16) <= (l3d_fxp2_t)depthbuffer[y * SCREEN_WIDTH + x] + bias;
+		if (visible) {
+			if (!in_run) {
+				run_x = x;
+				run_y = y;
+				in_run = true;
+			}
+			last_x = x;
+			last_y = y;
+		}
+		else if (in_run) {
+			if (last_x != run_x || last_y != run_y)
+				output(run_x, run_y, last_x, last_y, colour);
+			in_run = false;
+		}
+
+		if (steps-- == 0)
+			break;
+
+		int32_t e2 = 2 * err;
+		if (e2 >= dy) {
+			err += dy;
+			x += step_x;
+		}
+		if (e2 <= dx) {
+			err += dx;
+			y += step_y;
+		}
+		z += dz;
+	}
+
+	if (in_run && (last_x != run_x || last_y != run_y))
+		output(run_x, run_y, last_x, last_y, colour);
+}
+
+// 
+// Get the depth buffer, SCREEN_WIDTH * SCREEN_HEIGHT values, row by row
+// 
+l3d_depth_t *l3d_depthbuffer_getBuffer(void) {
+	return depthbuffer;
+}
+
+#endif	// REMOVE_HIDDEN_LINES
@@ -0,0 +1,133 @@
+#include "../Inc/lib3d_framebuffer.h"
+
+#ifdef L3D_USE_FRAMEBUFFER
+
+#include <stdlib.h>	// for abs()
+#include <string.h>	// for memset(), memcpy()
+
+static l3d_pixel_t framebuffer[SCREEN_WIDTH * SCREEN_HEIGHT];
+
+// 
+// Fill the whole framebuffer with given colour.
+// Only the first row is filled pixel by pixel,
+// the rest is copied from it.
+// 
+void l3d_framebuffer_clear(l3d_colour_t colour) {
+	l3d_pixel_t px = (l3d_pixel_t)colour;
+#ifdef COLOUR_SINGLE_BYTE
+	memset(framebuffer, px, sizeof(framebuffer));
+#else
+	for (int32_t x = 0; x < SCREEN_WIDTH; x++)
+		framebuffer[x] = px;
+	for (int32_t y = 1; y < SCREEN_HEIGHT; y++)
+		memcpy(&framebuffer[y * SCREEN_WIDTH], framebuffer, SCREEN_WIDTH * sizeof(l3d_pixel_t));
+#endif
+}
+
+// 
+// Horizontal span from x0 to x1 (inclusive) in row y
+// 
+static void drawHorizontalSpan(int32_t x0, int32_t x1, int32_t y, l3d_pixel_t px) {
+	if (x0 > x1) {
+		int32_t tmp = x0;
+		x0 = x1;
+		x1 = tmp;
+	}
+	l3d_pixel_t *p = &framebuffer[y * SCREEN_WIDTH + x0];
+#ifdef COLOUR_SINGLE_BYTE
+	memset(p, px, x1 - x0 + 1);
+#else
+	for (int32_t x = x0; x <= x1; x++)
+		*p++ = px;
+#endif
+}
+
+// 
+// Vertical span from y0 to y1 (inclusive) in column x
+// 
+static void drawVerticalSpan(int32_t x, int32_t y0, int32_t y1, l3d_pixel_t px) {
+	if (y0 > y1) {
+		int32_t tmp = y0;
+		y0 = y1;
+		y1 = tmp;
+	}
+	l3d_pixel_t *p = &framebuffer[y0 * SCREEN_WIDTH + x];
+	for (int32_t y = y0; y <= y1; y++) {
+		*p = px;
+		p += SCREEN_WIDTH;
+	}
+}
+
+// 
+// Rasterise a line into the framebuffer (Bresenham's algorithm,
+// integer arithmetic only).
+// The line is clipped to the framebuffer first,
+// so it may be given in any integer coordinates.
+// 
+void l3d_framebuffer_drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, l3d_colour_t colour) {
+	const l3d_rect_t screen = { 0, 0, SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1 };
+	if (!l3d_clipLineToRect(&x0, &y0, &x1, &y1, &screen))
+		return;
+
+	l3d_pixel_t px = (l3d_pixel_t)colour;
+
+	if (y0 == y1) {
+		drawHorizontalSpan(x0, x1, y0, px);
+		return;
+	}
+	if (x0 == x1) {
+		drawVerticalSpan(x0, y0, y1, px);
+		return;
+	}
+
+	int32_t dx = abs(x1 - x0);
+	int32_t dy = -abs(y1 - y0);
+	int32_t step_x = x0 < x1 ? 1 : -1;
+	int32_t step_y = y0 < y1 ? SCREEN_WIDTH : -SCREEN_WIDTH;
+	int32_t err = dx + dy;
+	int32_t steps = dx > -dy ? dx : -dy;
+
+	l3d_pixel_t *p = &framebuffer[y0 * SCREEN_WIDTH + x0];
+	*p = px;
+
+	while (steps--) {
+		int32_t e2 = 2 * err;
+		if (e2 >= dy) {
+			err += dy;
+			p += step_x;
+		}
+		if (e2 <= dx) {
+			err += dx;
+			p += step_y;
+		}
+		*p = px;
+	}
+}
+
+// 
+// Draw a horizontal span of pixels from x0 to x1 (inclusive) in row y.
+// The span is clipped to the framebuffer.
+// 
+void l3d_framebuffer_drawSpan(int32_t y, int32_t x0, int32_t x1, l3d_colour_t colour) {
+	if (x0 > x1) {
+		int32_t tmp = x0;
+		x0 = x1;
+		x1 = tmp;
+	}
+	if (y < 0 || y >= SCREEN_HEIGHT || x1 < 0 || x0 >= SCREEN_WIDTH)
+		return;
+	if (x0 < 0)
+		x0 = 0;
+	if (x1 >= SCREEN_WIDTH)
+		x1 = SCREEN_WIDTH - 1;
+	drawHorizontalSpan(x0, x1, y, (l3d_pixel_t)colour);
+}
+
+// 
+// Get the framebuffer, SCREEN_WIDTH * SCREEN_HEIGHT pixels, row by row
+// 
+l3d_pixel_t *l3d_framebuffer_getBuffer(void) {
+	return framebuffer;
+}
+
+#endif	// L3D_USE_FRAMEBUFFER
@@ -5,19 +5,397 @@
 #include <stdio.h> // for sprintf()
 #include <math.h>   // for M_PI
 
+#if defined(L3D_USE_SIMD) && !defined(L3D_COUNT_FIXED_POINT_OVERFLOWS) && (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define L3D_SIMD_X86
+#include <immintrin.h>  // for SSE4.1 and AVX2 intrinsics
+#include <stdatomic.h>  // for the kernel chosen at run time
+#define L3D_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define L3D_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+#ifdef L3D_COUNT_FIXED_POINT_OVERFLOWS
+static uint32_t l3d_fixedPointOverflows = 0;
+
+// 
+// Clamp a twice-wide result to the range of l3d_fxp_t and count it if it did not fit
+// 
+static l3d_fxp_t saturateFixed( l3d_fxp2_t num ){
+    if( num > INT32_MAX ){
+        l3d_fixedPointOverflows++;
+        return INT32_MAX;
+    }
+    if( num < INT32_MIN ){
+        l3d_fixedPointOverflows++;
+        return INT32_MIN;
+    }
+    return (l3d_fxp_t)num;
+}
+#define L3D_FXP_RESULT(num) saturateFixed(num)
+
+uint32_t l3d_getFixedPointOverflowCount(void){
+    return l3d_fixedPointOverflows;
+}
+
+void l3d_resetFixedPointOverflowCount(void){
+    l3d_fixedPointOverflows = 0;
+}
+#else
+#define L3D_FXP_RESULT(num) ((l3d_fxp_t)(num))
+#endif
+
+#ifndef L3D_USE_INTEGER_ONLY
 l3d_fxp_t l3d_floatToFixed( l3d_flp_t num ){
     return (l3d_fxp_t)( num * (l3d_flp_t)( 1 << L3D_FP_DP ) + ( num >= 0 ? 0.5 : -0.5 ) );
 }
+#endif
 l3d_flp_t l3d_fixedToFloat( l3d_fxp_t num ){
     return (l3d_flp_t)(num) / (l3d_flp_t)( 1 << L3D_FP_DP );
 }
 l3d_fxp_t l3d_fixedMul( l3d_fxp_t a, l3d_fxp_t b ){
-    return ( (l3d_fxp2_t)(a) * (l3d_fxp2_t)(b) ) >> L3D_FP_DP;
+    return L3D_FXP_RESULT( ( (l3d_fxp2_t)(a) * (l3d_fxp2_t)(b) ) >> L3D_FP_DP );
 }
 l3d_fxp_t l3d_fixedDiv( l3d_fxp_t a, l3d_fxp_t b ){
-    return ( (l3d_fxp2_t)(a) << L3D_FP_DP ) / (l3d_fxp2_t)(b);
+#ifdef L3D_COUNT_FIXED_POINT_OVERFLOWS
+    if( b == 0 )
+        return saturateFixed( a < 0 ? INT64_MIN : INT64_MAX );
+#endif
+    return L3D_FXP_RESULT( ( (l3d_fxp2_t)(a) << L3D_FP_DP ) / (l3d_fxp2_t)(b) );
+}
+
+// Constants with 30 fractional bits, converted by the compiler
+#define L3D_Q30(num) ((int64_t)( (num) * 1073741824.0 ))
+#define L3D_Q30_TO_FXP(num) ((l3d_fxp_t)( ( (num) + ( 1 << (29 - L3D_FP_DP) ) ) >> (30 - L3D_FP_DP) ))
+// Values with 16 fractional bits (the sine table), rounded
+#if L3D_FP_DP >= 16
+#define L3D_Q16_TO_FXP(num) ((l3d_fxp_t)( (num) << (L3D_FP_DP - 16) ))
+#else
+#define L3D_Q16_TO_FXP(num) ((l3d_fxp_t)( ( (num) + ( 1 << (15 - L3D_FP_DP) ) ) >> (16 - L3D_FP_DP) ))
+#endif
+
+// L3D_PI is too coarse for the trigonometric functions
+#define L3D_FXP_ONE ((l3d_fxp_t)( 1 << L3D_FP_DP ))
+#define L3D_FXP_PI ((l3d_fxp_t)( 3.14159265358979 * ( 1 << L3D_FP_DP ) + 0.5 ))
+#define L3D_FXP_HALF_PI ((l3d_fxp_t)( 1.57079632679490 * ( 1 << L3D_FP_DP ) + 0.5 ))
+
+// 
+// Angles are reduced to binary angles first: a full turn is 2^32,
+// so the range reduction is done by integer wrap-around.
+// 
+#define L3D_TURN_QUARTER ( (uint32_t)1 << 30 )
+#define L3D_INV_2PI_Q32 683565276   // 2^32 / (2 * pi)
+
+static uint32_t radToTurns( l3d_fxp_t angle ){
+    return (uint32_t)( ( (int64_t)angle * L3D_INV_2PI_Q32 ) >> L3D_FP_DP );
+}
+
+#if L3D_SIN_LUT_BITS == 0
+// 
+// Sine of the first quadrant, x is a quarter turn with 30 fractional bits.
+// Taylor series up to x^11, its error is below 2^-24 in that range.
+// 
+static l3d_fxp_t sinQuarter( uint32_t x ){
+    int64_t r = ( (int64_t)x * L3D_Q30( 1.57079632679490 ) ) >> 30;    // to radians
+    int64_t r2 = ( r * r ) >> 30;
+    int64_t p = L3D_Q30( -1.0 / 39916800.0 );
+    p = L3D_Q30(  1.0 / 362880.0 ) + ( ( p * r2 ) >> 30 );
+    p = L3D_Q30( -1.0 / 5040.0 ) + ( ( p * r2 ) >> 30 );
+    p = L3D_Q30(  1.0 / 120.0 ) + ( ( p * r2 ) >> 30 );
+    p = L3D_Q30( -1.0 / 6.0 ) + ( ( p * r2 ) >> 30 );
+    p = L3D_Q30(  1.0 ) + ( ( p * r2 ) >> 30 );
+    return L3D_Q30_TO_FXP( ( r * p ) >> 30 );
+}
+#else
+#if L3D_SIN_LUT_BITS == 6
+// sin(i / 64 * pi / 2) with 16 fractional bits, entry 64 (1.0) is implied
+static const uint16_t l3d_sinLut[64] = {
+        0,  1608,  3216,  4821,  6424,  8022,  9616, 11204, 12785, 14359, 15924, 17479,
+    19024, 20557, 22078, 23586, 25080, 26558, 28020, 29466, 30893, 32303, 33692, 35062,
+    36410, 37736, 39040, 40320, 41576, 42806, 44011, 45190, 46341, 47464, 48559, 49624,
+    50660, 51665, 52639, 53581, 54491, 55368, 56212, 57022, 57798, 58538, 59244, 59914,
+    60547, 61145, 61705, 62228, 62714, 63162, 63572, 63944, 64277, 64571, 64827, 65043,
+    65220, 65358, 65457, 65516
+};
+#elif L3D_SIN_LUT_BITS == 8
+// sin(i / 256 * pi / 2) with 16 fractional bits, entry 256 (1.0) is implied
+static const uint16_t l3d_sinLut[256] = {
+        0,   402,   804,  1206,  1608,  2010,  2412,  2814,  3216,  3617,  4019,  4420,
+     4821,  5222,  5623,  6023,  6424,  6824,  7224,  7623,  8022,  8421,  8820,  9218,
+     9616, 10014, 10411, 10808, 11204, 11600, 11996, 12391, 12785, 13180, 13573, 13966,
+    14359, 14751, 15143, 15534, 15924, 16314, 16703, 17091, 17479, 17867, 18253, 18639,
+    19024, 19409, 19792, 20175, 20557, 20939, 21320, 21699, 22078, 22457, 22834, 23210,
+    23586, 23961, 24335, 24708, 25080, 25451, 25821, 26190, 26558, 26925, 27291, 27656,
+    28020, 28383, 28745, 29106, 29466, 29824, 30182, 30538, 30893, 31248, 31600, 31952,
+    32303, 32652, 33000, 33347, 33692, 34037, 34380, 34721, 35062, 35401, 35738, 36075,
+    36410, 36744, 37076, 37407, 37736, 38064, 38391, 38716, 39040, 39362, 39683, 40002,
+    40320, 40636, 40951, 41264, 41576, 41886, 42194, 42501, 42806, 43110, 43412, 43713,
+    44011, 44308, 44604, 44898, 45190, 45480, 45769, 46056, 46341, 46624, 46906, 47186,
+    47464, 47741, 48015, 48288, 48559, 48828, 49095, 49361, 49624, 49886, 50146, 50404,
+    50660, 50914, 51166, 51417, 51665, 51911, 52156, 52398, 52639, 52878, 53114, 53349,
+    53581, 53812, 54040, 54267, 54491, 54714, 54934, 55152, 55368, 55582, 55794, 56004,
+    56212, 56418, 56621, 56823, 57022, 57219, 57414, 57607, 57798, 57986, 58172, 58356,
+    58538, 58718, 58896, 59071, 59244, 59415, 59583, 59750, 59914, 60075, 60235, 60392,
+    60547, 60700, 60851, 60999, 61145, 61288, 61429, 61568, 61705, 61839, 61971, 62101,
+    62228, 62353, 62476, 62596, 62714, 62830, 62943, 63054, 63162, 63268, 63372, 63473,
+    63572, 63668, 63763, 63854, 63944, 64031, 64115, 64197, 64277, 64354, 64429, 64501,
+    64571, 64639, 64704, 64766, 64827, 64884, 64940, 64993, 65043, 65091, 65137, 65180,
+    65220, 65259, 65294, 65328, 65358, 65387, 65413, 65436, 65457, 65476, 65492, 65505,
+    65516, 65525, 65531, 65535
+};
+#else
+#error "L3D_SIN_LUT_BITS must be 0, 6 or 8"
+#endif
+
+#define L3D_SIN_LUT_SIZE ( 1 << L3D_SIN_LUT_BITS )
+#define L3D_SIN_LUT_FRAC_BITS ( 30 - L3D_SIN_LUT_BITS )
+
+// 
+// Sine of the first quadrant, x is a quarter turn with 30 fractional bits.
+// Table lookup with linear interpolation.
+// 
+static l3d_fxp_t sinQuarter( uint32_t x ){
+    uint32_t i = x >> L3D_SIN_LUT_FRAC_BITS;
+    if( i == L3D_SIN_LUT_SIZE )
+        return L3D_FXP_ONE;
+    int32_t lo = l3d_sinLut[i];
+    int32_t hi = i == L3D_SIN_LUT_SIZE - 1 ? ( 1 << 16 ) : l3d_sinLut[i + 1];
+    // 16 bits of the position between the entries keep the product in 32 bits
+    int32_t frac = ( x >> ( L3D_SIN_LUT_FRAC_BITS - 16 ) ) & 0xFFFF;
+    return L3D_Q16_TO_FXP( lo + ( ( ( hi - lo ) * frac + 0x8000 ) >> 16 ) );
+}
+#endif  // L3D_SIN_LUT_BITS
+
+static l3d_fxp_t sinTurns( uint32_t turns ){
+    uint32_t x = turns & ( L3D_TURN_QUARTER - 1 );
+    uint32_t quadrant = turns >> 30;
+    // sin(pi - x) = sin(x)
+    if( quadrant & 1 )
+        x = L3D_TURN_QUARTER - x;
+    l3d_fxp_t s = sinQuarter( x );
+    return quadrant & 2 ? -s : s;
+}
+
+l3d_fxp_t l3d_fixedSin( l3d_fxp_t angle ){
+    return sinTurns( radToTurns( angle ) );
+}
+
+l3d_fxp_t l3d_fixedCos( l3d_fxp_t angle ){
+    // cos(x) = sin(x + pi/2)
+    return sinTurns( radToTurns( angle ) + L3D_TURN_QUARTER );
+}
+
+#if L3D_CORDIC_ITERATIONS < 1 || L3D_CORDIC_ITERATIONS > 24
+#error "L3D_CORDIC_ITERATIONS must be between 1 and 24"
+#endif
+
+// atan(2^-i) with 30 fractional bits
+static const int32_t l3d_cordicAtan[24] = {
+    843314857, 497837829, 263043837, 133525159, 67021687, 33543516,
+    16775851, 8388437, 4194283, 2097149, 1048576, 524288,
+    262144, 131072, 65536, 32768, 16384, 8192,
+    4096, 2048, 1024, 512, 256, 128
+};
+
+// 
+// CORDIC in vectoring mode: (x, y) is rotated onto the x axis
+// by +-atan(2^-i) steps, which add up to the angle.
+// Each iteration gives about one bit of precision.
+// 
+l3d_fxp_t l3d_fixedAtan2( l3d_fxp_t y, l3d_fxp_t x ){
+    if( x == 0 && y == 0 )
+        return 0;
+
+    // Scale the vector to 28..29 bits: precise for short vectors,
+    // and the CORDIC gain of 1.65 still fits in 32 bits
+    int64_t vx = x, vy = y;
+    uint64_t ax = vx < 0 ? -vx : vx;
+    uint64_t ay = vy < 0 ? -vy : vy;
+    uint64_t max = ax > ay ? ax : ay;
+    while( max >= ( 1 << 29 ) ){
+        max >>= 1;
+        vx /= 2;
+        vy /= 2;
+    }
+    while( max < ( 1 << 28 ) ){
+        max <<= 1;
+        vx *= 2;
+        vy *= 2;
+    }
+
+    // Rotate the left half-plane by pi
+    int32_t offset = 0;
+    if( vx < 0 ){
+        offset = y < 0 ? -L3D_FXP_PI : L3D_FXP_PI;
+        vx = -vx;
+        vy = -vy;
+    }
+
+    int32_t cx = (int32_t)vx, cy = (int32_t)vy, angle = 0;
+    for( uint8_t i = 0; i < L3D_CORDIC_ITERATIONS; i++ ){
+        int32_t dx = cx >> i;
+        int32_t dy = cy >> i;
+        if( cy > 0 ){
+            cx += dy;
+            cy -= dx;
+            angle += l3d_cordicAtan[i];
+        }
+        else {
+            cx -= dy;
+            cy += dx;
+            angle -= l3d_cordicAtan[i];
+        }
+    }
+    return L3D_Q30_TO_FXP( (int64_t)angle ) + offset;
 }
+
+l3d_fxp_t l3d_fixedAsin( l3d_fxp_t x ){
+    if( x >= L3D_FXP_ONE )
+        return L3D_FXP_HALF_PI;
+    if( x <= -L3D_FXP_ONE )
+        return -L3D_FXP_HALF_PI;
+    // asin(x) = atan2(x, sqrt(1 - x^2))
+    return l3d_fixedAtan2( x, l3d_fixedSqrt( L3D_FXP_ONE - l3d_fixedMul( x, x ) ) );
+}
+
+// 
+// Square root, rounded down
+// 
+l3d_fxp_t l3d_fixedSqrt( l3d_fxp_t x ){
+    if( x <= 0 )
+        return 0;
+
+    // x has L3D_FP_DP fractional bits, so sqrt(x * 2^L3D_FP_DP) has L3D_FP_DP as well
+    uint64_t n = (uint64_t)x << L3D_FP_DP;
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while( bit > n )
+        bit >>= 2;
+    while( bit != 0 ){
+        if( n >= root + bit ){
+            n -= root + bit;
+            root = ( root >> 1 ) + bit;
+        }
+        else
+            root >>= 1;
+        bit >>= 2;
+    }
+    return (l3d_fxp_t)root;
+}
+
+// 1 / sqrt(x) for x in [8/32, 32/32) in steps of 1/32, with 30 fractional bits
+static const uint32_t l3d_rsqrtSeed[24] = {
+    2086075324, 1972717383, 1876073988, 1792396632, 1719018915, 1653984912,
+    1595822683, 1543400282, 1495830939, 1452408697, 1412563581, 1375829655,
+    1341821798, 1310218524, 1280749062, 1253183511, 1227325231, 1203004900,
+    1180075819, 1158410165, 1137895982, 1118434729, 1099939286, 1082332304
+};
+
+// 
+// Reciprocal square root of a sum of squares of rationals
+// (2 * L3D_FP_DP fractional bits, must not be 0).
+// Returns r with 30 fractional bits and sets *shift,
+// so that x / sqrt(sq) = ( x * r ) >> *shift for a rational x.
+// 
+static uint32_t invSqrtScale( uint64_t sq, uint8_t *shift ){
+    // sq = m * 2^e, with m in [1/4, 1) (30 fractional bits) and even e
+    int8_t e = 0;
+    while( ( sq >> e ) >= ( (uint64_t)1 << 30 ) )
+        e += 2;
+    uint64_t m = sq >> e;
+    while( m < ( (uint64_t)1 << 28 ) ){
+        m <<= 2;
+        e -= 2;
+    }
+
+    // Newton's method: r = r * (3 - m * r^2) / 2
+    uint64_t r = l3d_rsqrtSeed[( m >> 25 ) - 8];
+    for( uint8_t i = 0; i < L3D_RSQRT_ITERATIONS; i++ ){
+        uint64_t r2 = ( r * r ) >> 30;
+        uint64_t mr2 = ( m * r2 ) >> 30;
+        r = ( r * ( ( (uint64_t)3 << 30 ) - mr2 ) ) >> 31;
+    }
+
+    // x / sqrt(sq) = x * r * 2^(-30 - (e - 2) / 2), the quotient keeps L3D_FP_DP fractional bits
+    *shift = (uint8_t)( 45 - L3D_FP_DP + e / 2 );
+    return (uint32_t)r;
+}
+
+// 
+// ( x * r ) >> shift, rounded, for the scale factors
+// returned by invSqrtScale() and reciprocalScale()
+// 
+static l3d_fxp_t applyScale( l3d_fxp_t x, uint32_t r, uint8_t shift ){
+    return L3D_FXP_RESULT( ( (int64_t)x * r + ( (int64_t)1 << ( shift - 1 ) ) ) >> shift );
+}
+
+l3d_fxp_t l3d_fixedRsqrt( l3d_fxp_t x ){
+    if( x <= 0 )
+        return 0;
+    uint8_t shift;
+    uint32_t r = invSqrtScale( (uint64_t)x << L3D_FP_DP, &shift );
+    return applyScale( L3D_FXP_ONE, r, shift );
+}
+
+#ifdef L3D_USE_RECIPROCAL_DIVIDE
+// 1 / m for m in [1, 2) in steps of 1/64 (taken at the middle of each step), with 16 fractional bits
+static const uint16_t l3d_reciprocalSeed[64] = {
+    65028, 64035, 63072, 62138, 61231, 60350, 59494, 58662, 57852, 57065, 56299,
+    55554, 54828, 54120, 53431, 52759, 52103, 51464, 50840, 50231, 49637, 49056,
+    48489, 47935, 47393, 46864, 46346, 45839, 45344, 44859, 44384, 43919, 43464,
+    43019, 42582, 42154, 41734, 41323, 40920, 40525, 40137, 39756, 39383, 39017,
+    38657, 38304, 37958, 37617, 37283, 36954, 36631, 36314, 36003, 35696, 35395,
+    35099, 34808, 34521, 34239, 33962, 33689, 33421, 33157, 32897
+};
+
+// 
+// Reciprocal of a positive rational a (must not be 0).
+// Returns r with 31 fractional bits and sets *shift,
+// so that x / a = ( x * r ) >> *shift for a rational x.
+// 
+static uint32_t reciprocalScale( uint32_t a, uint8_t *shift ){
+    // a = m * 2^-n, with m in [1, 2) (31 fractional bits)
+    uint8_t n = 0;
+    uint64_t m = a;
+    for( uint8_t step = 16; step > 0; step >>= 1 ){
+        if( m < ( (uint64_t)1 << ( 32 - step ) ) ){
+            m <<= step;
+            n += step;
+        }
+    }
+
+    // Newton's method: r = r * (2 - m * r)
+    uint64_t r = (uint64_t)l3d_reciprocalSeed[( m >> 25 ) & 0x3F] << 15;
+    for( uint8_t i = 0; i < L3D_RECIPROCAL_ITERATIONS; i++ ){
+        uint64_t mr = ( m * r ) >> 31;
+        r = ( r * ( ( (uint64_t)2 << 31 ) - mr ) ) >> 31;
+    }
+
+    // x / a = x * r * 2^(n - 62), the quotient keeps L3D_FP_DP fractional bits
+    *shift = (uint8_t)( 62 - n - L3D_FP_DP );
+    return (uint32_t)r;
+}
+
+// 
+// Same as l3d_vec4_div() but with one reciprocal of k
+// and three multiplications instead of three l3d_fixedDiv()s
+// 
+static l3d_vec4_t vec4_divByReciprocal( const l3d_vec4_t *v, l3d_rtnl_t k ){
+    if( abs(k) < L3D_EPSILON_RTNL ){
+        L3D_DEBUG_PRINT( "Error: division by 0. Returining original vector.\n" );
+        return *v;
+    }
+
+    uint8_t shift;
+    uint32_t r = reciprocalScale( k < 0 ? -(uint32_t)k : (uint32_t)k, &shift );
+    l3d_vec4_t q = { applyScale( v->x, r, shift ), applyScale( v->y, r, shift ), applyScale( v->z, r, shift ), v->h };
+    if( k < 0 ){
+        q.x = -q.x;
+        q.y = -q.y;
+        q.z = -q.z;
+    }
+    return q;
+}
+#endif
 #endif
 
 // 
@@ -25,13 +403,25 @@ l3d_fxp_t l3d_fixedDiv( l3d_fxp_t a, l3d_fxp_t b ){
 // If fixed point arithmetic is used, the argument is converted to l3d_flp_t.
 // 
 int32_t l3d_rationalToInt32(l3d_rtnl_t num){
-#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+#if defined(L3D_USE_INTEGER_ONLY)
+    // Rounds towards zero, like the conversion through l3d_flp_t
+    return num / ( 1 << L3D_FP_DP );
+#elif defined(L3D_USE_FIXED_POINT_ARITHMETIC)
     return (int32_t)l3d_fixedToFloat(num);
 #else
     return (int32_t)num;
 #endif
 }
 
+l3d_rtnl_t l3d_int32ToRational(int32_t num){
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+    return (l3d_rtnl_t)( num * ( 1 << L3D_FP_DP ) );
+#else
+    return (l3d_rtnl_t)num;
+#endif
+}
+
+#ifndef L3D_USE_INTEGER_ONLY
 // 
 // Returns a rational number.
 // If fixed point arithmetic is used, the argument is converted to l3d_fxp_t.
@@ -43,6 +433,7 @@ l3d_rtnl_t l3d_floatToRational(l3d_flp_t num){
     return num;
 #endif
 }
+#endif
 
 l3d_flp_t l3d_rationalToFloat(l3d_rtnl_t num){
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
@@ -52,6 +443,7 @@ l3d_flp_t l3d_rationalToFloat(l3d_rtnl_t num){
 #endif
 }
 
+#ifndef L3D_USE_INTEGER_ONLY
 // 
 // Returns rotation struct.
 // If fixed point arithmetic is used, arguments are converted to l3d_fxp_t.
@@ -93,6 +485,7 @@ l3d_vec4_t l3d_getVec4FromFloat(l3d_flp_t x, l3d_flp_t y, l3d_flp_t z, l3d_flp_t
 l3d_quat_t l3d_getQuatFromFloat(l3d_flp_t w, l3d_flp_t x, l3d_flp_t y, l3d_flp_t z) {
     return (l3d_quat_t){l3d_floatToRational(w), l3d_floatToRational(x), l3d_floatToRational(y), l3d_floatToRational(z)};
 }
+#endif  // L3D_USE_INTEGER_ONLY
 
 l3d_rtnl_t l3d_getZeroRtnl(void){
     return l3d_floatToRational(0.0f);
@@ -126,6 +519,7 @@ l3d_rtnl_t l3d_radToDegR(l3d_rtnl_t rad) {
 #endif
 }
 
+#ifndef L3D_USE_INTEGER_ONLY
 l3d_flp_t l3d_degToRadF(l3d_flp_t deg) {
     return deg * (L3D_PI / 180.0f);
 }
@@ -133,6 +527,7 @@ l3d_flp_t l3d_degToRadF(l3d_flp_t deg) {
 l3d_flp_t l3d_radToDegF(l3d_flp_t rad) {
     return rad * (180.0f / L3D_PI);
 }
+#endif
 
 l3d_rot_t l3d_quatToEuler(const l3d_quat_t *q) {
     // l3d_rot_t result;
@@ -141,107 +536,24 @@ l3d_rot_t l3d_quatToEuler(const l3d_quat_t *q) {
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
     // From
     // https://danceswithcode.net/engineeringnotes/quaternions/quaternions.html
-    l3d_flp_t qw = l3d_fixedToFloat(q->w);
-    l3d_flp_t qx = l3d_fixedToFloat(q->x);
-    l3d_flp_t qy = l3d_fixedToFloat(q->y);
-    l3d_flp_t qz = l3d_fixedToFloat(q->z);
-
-    l3d_flp_t yaw, pitch, roll;
+    l3d_fxp_t ww = l3d_fixedMul(q->w, q->w);
+    l3d_fxp_t xx = l3d_fixedMul(q->x, q->x);
+    l3d_fxp_t yy = l3d_fixedMul(q->y, q->y);
+    l3d_fxp_t zz = l3d_fixedMul(q->z, q->z);
 
-    yaw = atan2f(2.0f * (qw*qz + qx*qy), qw*qw + qx*qx - qy*qy - qz*qz);
-    roll = asinf(2.0f * (qw*qy - qx*qz));
+    euler.yaw = l3d_fixedAtan2(2 * (l3d_fixedMul(q->w, q->z) + l3d_fixedMul(q->x, q->y)), ww + xx - yy - zz);
+    euler.roll = l3d_fixedAsin(2 * (l3d_fixedMul(q->w, q->y) - l3d_fixedMul(q->x, q->z)));
 
-    if (roll - M_PI/2.0f < L3D_EPSILON_FLP) {
-        pitch = 0.0f;
-        yaw = -2.0f * atan2f(qx, qw);
+    if (euler.roll - L3D_FXP_HALF_PI < L3D_EPSILON_RTNL) {
+        euler.pitch = 0;
+        euler.yaw = -2 * l3d_fixedAtan2(q->x, q->w);
     }
-    else if (roll - (-M_PI/2.0f) < L3D_EPSILON_FLP) {
-        pitch = 0.0f;
-        yaw = 2.0f * atan2f(qx, qw);
+    else if (euler.roll + L3D_FXP_HALF_PI < L3D_EPSILON_RTNL) {
+        euler.pitch = 0;
+        euler.yaw = 2 * l3d_fixedAtan2(q->x, q->w);
     }
     else
-        pitch = atan2f(2.0f * (qw*qx + qy*qz), qw*qw - qx*qx - qy*qy + qz*qz);
-
-    euler.yaw = l3d_floatToFixed(yaw);
-    euler.pitch = l3d_floatToFixed(pitch);
-    euler.roll = l3d_floatToFixed(roll);
-
-    // First test if the formula even works
-    // l3d_rtnl_t qwx = l3d_fixedMul(q->w, q->x);
-    // l3d_rtnl_t qyz = l3d_fixedMul(q->y, q->z);
-    // l3d_rtnl_t qx2 = l3d_fixedMul(q->x, q->x);
-    // l3d_rtnl_t qy2 = l3d_fixedMul(q->y, q->y);
-    // l3d_rtnl_t qz2 = l3d_fixedMul(q->z, q->z);
-    // l3d_rtnl_t qwy = l3d_fixedMul(q->w, q->y);
-    // l3d_rtnl_t qxz = l3d_fixedMul(q->x, q->z);
-    // l3d_rtnl_t qwz = l3d_fixedMul(q->w, q->z);
-    // l3d_rtnl_t qxy = l3d_fixedMul(q->x, q->y);
-
-    // result.yaw = l3d_floatToRational(atan2f(l3d_fixedMul(2, (qwx + qyz)), 1-l3d_fixedMul(2, (qx2 + qy2))));
-    // result.pitch = l3d_floatToRational(asinf(2*(qwy + qxz)));
-    // result.roll = l3d_floatToRational(atan2f(2*(qwz + qxy), 1-2*(qy2 + qz2)));
-
-    // l3d_flp_t w, x, y, z;
-    // w = l3d_fixedToFloat(q->w);
-    // x = l3d_fixedToFloat(q->x);
-    // y = l3d_fixedToFloat(q->y);
-    // z = l3d_fixedToFloat(q->z);
-    // l3d_flp_t yaw, pitch, roll;
-    // yaw = atan2f(2.0f*(w * x + y * z), 1.0f-2.0f*(x * x + y * y));
-    // pitch = asinf(2.0f*(w * y + x * z));
-    // roll = atan2f(2.0f*(w * z + x * y), 1.0f-2.0f*(y * y + z * z));
-
-    // result.yaw = l3d_floatToFixed(yaw);
-    // result.pitch = l3d_floatToFixed(pitch);
-    // result.roll = l3d_floatToFixed(roll);
-
-    // // CHATGPT 3
-    // l3d_flp_t qw = l3d_fixedToFloat(q->w);
-    // l3d_flp_t qx = l3d_fixedToFloat(q->x);
-    // l3d_flp_t qy = l3d_fixedToFloat(q->y);
-    // l3d_flp_t qz = l3d_fixedToFloat(q->z);
-
-    // // Pitch (X-axis rotation)
-    // l3d_flp_t sinp = 2.0f * (qw * qx - qy * qz);
-    // if (fabsf(sinp) >= 1.0f)
-    //     euler.pitch = l3d_floatToFixed(copysignf(M_PI / 2.0f, sinp)); // Use 90 degrees if out of range
-    // else
-    //     euler.pitch = l3d_floatToFixed(asinf(sinp));
-
-    // // Yaw (Z-axis)
-    // euler.yaw = l3d_floatToFixed(atan2f(
-    //     2.0f * (qw * qz + qx * qy),
-    //     1.0f - 2.0f * (qx * qx + qz * qz)
-    // ));
-
-    // // Roll (Y-axis)
-    // euler.roll = l3d_floatToFixed(atan2f(
-    //     2.0f * (qw * qy + qz * qx),
-    //     1.0f - 2.0f * (qx * qx + qy * qy)
-    // ));
-
-    // CHATGPT 2
-    // l3d_flp_t x = l3d_fixedToFloat(q->x);
-    // l3d_flp_t y = l3d_fixedToFloat(q->y);
-    // l3d_flp_t z = l3d_fixedToFloat(q->z);
-    // l3d_flp_t w = l3d_fixedToFloat(q->w);
-
-    // // ZXY extraction
-    // l3d_flp_t sin_pitch = 2.0f * (w * x - y * z);
-    // euler.pitch = fabsf(sin_pitch) >= 1.0f
-    //     ? l3d_floatToFixed(copysignf(M_PI / 2.0f, sin_pitch))
-    //     : l3d_floatToFixed(asinf(sin_pitch));
-
-    // euler.yaw = l3d_floatToFixed(atan2f(
-    //     2.0f * (x * y + w * z),
-    //     w * w + x * x - y * y - z * z
-    // ));
-
-    // euler.roll = l3d_floatToFixed(atan2f(
-    //     2.0f * (x * z + w * y),
-    //     w * w - x * x - y * y + z * z
-    // ));
-
+        euler.pitch = l3d_fixedAtan2(2 * (l3d_fixedMul(q->w, q->x) + l3d_fixedMul(q->y, q->z)), ww - xx - yy + zz);
 #else
     // result.yaw = atan2f(2.0f*(q->w * q->x + q->y * q->z), 1.0f-2.0f*(q->x * q->x + q->y * q->y));
     // result.pitch = asinf(2.0f*(q->w * q->y + q->x * q->z));
@@ -271,11 +583,13 @@ l3d_rot_t l3d_quatToEuler(const l3d_quat_t *q) {
     return euler;
 }
 
+#ifndef L3D_USE_INTEGER_ONLY
 l3d_quat_t l3d_eulerAnglesToQuat(l3d_flp_t yaw, l3d_flp_t pitch, l3d_flp_t roll) {
     l3d_rot_t r = l3d_getRotFromFloat(yaw, pitch, roll);
 
     return l3d_eulerToQuat(&r);
 }
+#endif
 
 l3d_quat_t l3d_eulerToQuat(const l3d_rot_t *r) {
     // TODO: clean up this function
@@ -290,6 +604,22 @@ l3d_quat_t l3d_eulerToQuat(const l3d_rot_t *r) {
     // the first rotation goes to the right.
     // See https://math.stackexchange.com/a/2975462
 
+    l3d_quat_t result;
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+    l3d_fxp_t cz = l3d_fixedCos(r->yaw / 2);
+    l3d_fxp_t sz = l3d_fixedSin(r->yaw / 2);
+    l3d_fxp_t cx = l3d_fixedCos(r->pitch / 2);
+    l3d_fxp_t sx = l3d_fixedSin(r->pitch / 2);
+    l3d_fxp_t cy = l3d_fixedCos(r->roll / 2);
+    l3d_fxp_t sy = l3d_fixedSin(r->roll / 2);
+
+    // Rotation order: Z (yaw), then X (pitch), then Y (roll)
+    result.w = l3d_fixedMul(l3d_fixedMul(cz, cx), cy) - l3d_fixedMul(l3d_fixedMul(sz, sx), sy);
+    result.x = l3d_fixedMul(l3d_fixedMul(cz, sx), cy) - l3d_fixedMul(l3d_fixedMul(sz, cx), sy);
+    result.y = l3d_fixedMul(l3d_fixedMul(cz, cx), sy) + l3d_fixedMul(l3d_fixedMul(sz, sx), cy);
+    result.z = l3d_fixedMul(l3d_fixedMul(sz, cx), cy) + l3d_fixedMul(l3d_fixedMul(cz, sx), sy);
+    return result;
+#else
     // First test if the formula even forks
     l3d_flp_t half_yaw = l3d_rationalToFloat(r->yaw) * 0.5f;
     l3d_flp_t half_pitch = l3d_rationalToFloat(r->pitch) * 0.5f;
@@ -302,33 +632,6 @@ l3d_quat_t l3d_eulerToQuat(const l3d_rot_t *r) {
     // l3d_flp_t cr = cosf(half_roll);
     // l3d_flp_t sr = sinf(half_roll);
 
-    l3d_quat_t result;
-#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
-    // result.w = l3d_floatToFixed(cy * cp * cr + sy * sp * sr);
-    // result.x = l3d_floatToFixed(sy * cp * cr - cy * sp * sr);
-    // result.y = l3d_floatToFixed(cy * sp * cr + sy * cp * sr);
-    // result.z = l3d_floatToFixed(cy * cp * sr - sy * sp * cr);
-
-    l3d_flp_t cz = cosf(half_yaw);
-    l3d_flp_t sz = sinf(half_yaw);
-    l3d_flp_t cx = cosf(half_pitch);
-    l3d_flp_t sx = sinf(half_pitch);
-    l3d_flp_t cy = cosf(half_roll);
-    l3d_flp_t sy = sinf(half_roll);
-
-    // Rotation order: Z (yaw), then X (pitch), then Y (roll)
-    result.w = l3d_floatToFixed(cz * cx * cy - sz * sx * sy);
-    result.x = l3d_floatToFixed(cz * sx * cy - sz * cx * sy);
-    result.y = l3d_floatToFixed(cz * cx * sy + sz * sx * cy);
-    result.z = l3d_floatToFixed(sz * cx * cy + cz * sx * sy);
-
-    // // Rotation order: Z (yaw), then X (pitch), then Y (roll)
-    // result.w = cz * cx * cy - sz * sx * sy;
-    // result.x = cz * sx * cy - sz * cx * sy;
-    // result.y = cz * cx * sy + sz * sx * cy;
-    // result.z = sz * cx * cy + cz * sx * sy;
-
-#else
     l3d_flp_t cz = cosf(half_yaw);
     l3d_flp_t sz = sinf(half_yaw);
     l3d_flp_t cx = cosf(half_pitch);
@@ -340,73 +643,179 @@ l3d_quat_t l3d_eulerToQuat(const l3d_rot_t *r) {
     result.x = (cz * sx * cy - sz * cx * sy);
     result.y = (cz * cx * sy + sz * sx * cy);
     result.z = (sz * cx * cy + cz * sx * sy);
-#endif
 
     return result;
+#endif  // L3D_USE_FIXED_POINT_ARITHMETIC
 }
 
-void l3d_quatToRotMat(l3d_mat4x4_t *m, const l3d_quat_t *q) {
+// 
+// Rotation by q followed by translation by pos,
+// the same as l3d_quatToRotMat() times l3d_mat4x4_makeTranslation()
+// 
+void l3d_quatToAffine(l3d_mat3x4_t *m, const l3d_quat_t *q, const l3d_vec4_t *pos) {
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
     // Equation (7b) from https://danceswithcode.net/engineeringnotes/quaternions/quaternions.html
-    
-    l3d_flp_t qw = l3d_fixedToFloat(q->w);
-    l3d_flp_t qx = l3d_fixedToFloat(q->x);
-    l3d_flp_t qy = l3d_fixedToFloat(q->y);
-    l3d_flp_t qz = l3d_fixedToFloat(q->z);
-
-    m->m[0][0] = l3d_floatToRational(1.0f - 2.0f * (qy*qy + qz*qz));
-    m->m[0][1] = l3d_floatToRational(2.0f * qx*qy - 2.0f * qw*qz);
-    m->m[0][2] = l3d_floatToRational(2.0f * qx*qz + 2.0f * qw*qy);
-    m->m[0][3] = l3d_floatToRational(0.0f);
-
-    m->m[1][0] = l3d_floatToRational(2.0f * qx*qy + 2.0f * qw * qz);
-    m->m[1][1] = l3d_floatToRational(1.0f - 2.0f * qx * qx - 2.0f * qz * qz);
-    m->m[1][2] = l3d_floatToRational(2.0f * qy * qz - 2.0f * qw * qx);
-    m->m[1][3] = l3d_floatToRational(0.0f);
-
-    m->m[2][0] = l3d_floatToRational(2.0f * qx * qz - 2.0f * qw * qy);
-    m->m[2][1] = l3d_floatToRational(2.0f * qy * qz + 2.0f * qw * qx);
-    m->m[2][2] = l3d_floatToRational(1.0f - 2.0f * qx * qx - 2.0f * qy * qy);
-    m->m[2][3] = l3d_floatToRational(0.0f);
-
-    m->m[3][0] = l3d_floatToRational(0.0f);
-    m->m[3][1] = l3d_floatToRational(0.0f);
-    m->m[3][2] = l3d_floatToRational(0.0f);
-    m->m[3][3] = l3d_floatToRational(1.0f);
+    l3d_fxp_t xx = l3d_fixedMul(q->x, q->x);
+    l3d_fxp_t yy = l3d_fixedMul(q->y, q->y);
+    l3d_fxp_t zz = l3d_fixedMul(q->z, q->z);
+    l3d_fxp_t xy = l3d_fixedMul(q->x, q->y);
+    l3d_fxp_t xz = l3d_fixedMul(q->x, q->z);
+    l3d_fxp_t yz = l3d_fixedMul(q->y, q->z);
+    l3d_fxp_t wx = l3d_fixedMul(q->w, q->x);
+    l3d_fxp_t wy = l3d_fixedMul(q->w, q->y);
+    l3d_fxp_t wz = l3d_fixedMul(q->w, q->z);
+    l3d_fxp_t one = l3d_floatToFixed(1.0f);
+
+    m->m[0][0] = one - 2 * (yy + zz);
+    m->m[0][1] = 2 * (xy - wz);
+    m->m[0][2] = 2 * (xz + wy);
+
+    m->m[1][0] = 2 * (xy + wz);
+    m->m[1][1] = one - 2 * (xx + zz);
+    m->m[1][2] = 2 * (yz - wx);
+
+    m->m[2][0] = 2 * (xz - wy);
+    m->m[2][1] = 2 * (yz + wx);
+    m->m[2][2] = one - 2 * (xx + yy);
+
+    m->m[3][0] = pos->x;
+    m->m[3][1] = pos->y;
+    m->m[3][2] = pos->z;
 #else
     // Equation (7b) from https://danceswithcode.net/engineeringnotes/quaternions/quaternions.html
     m->m[0][0] = 1.0f - 2.0f * (q->y*q->y + q->z*q->z);
     m->m[0][1] = 2.0f * q->x*q->y - 2.0f * q->w*q->z;
     m->m[0][2] = 2.0f * q->x*q->z + 2.0f * q->w*q->y;
-    m->m[0][3] = 0.0f;
 
     m->m[1][0] = 2.0f * q->x*q->y + 2.0f * q->w * q->z;
     m->m[1][1] = 1.0f - 2.0f * q->x * q->x - 2.0f * q->z * q->z;
     m->m[1][2] = 2.0f * q->y * q->z - 2.0f * q->w * q->x;
-    m->m[1][3] = 0.0f;
 
     m->m[2][0] = 2.0f * q->x * q->z - 2.0f * q->w * q->y;
     m->m[2][1] = 2.0f * q->y * q->z + 2.0f * q->w * q->x;
     m->m[2][2] = 1.0f - 2.0f * q->x * q->x - 2.0f * q->y * q->y;
-    m->m[2][3] = 0.0f;
 
-    m->m[3][0] = 0.0f;
-    m->m[3][1] = 0.0f;
-    m->m[3][2] = 0.0f;
-    m->m[3][3] = 1.0f;
+    m->m[3][0] = pos->x;
+    m->m[3][1] = pos->y;
+    m->m[3][2] = pos->z;
 #endif // L3D_USE_FIXED_POINT_ARITHMETIC
 }
 
+void l3d_quatToRotMat(l3d_mat4x4_t *m, const l3d_quat_t *q) {
+    l3d_mat3x4_t affine;
+    l3d_vec4_t origin = l3d_getZeroVec4();
+    l3d_quatToAffine(&affine, q, &origin);
+    l3d_mat3x4_toMat4x4(m, &affine);
+}
+
+// 
+// Rotation part of an affine matrix as a quaternion
+// 
+l3d_quat_t l3d_affineToQuat(const l3d_mat3x4_t *m) {
+    // Inverse of Equation (7b) (see l3d_quatToAffine()), from
+    // https://www.euclideanspace.com/maths/geometry/rotations/conversions/matrixToQuaternion/
+    // The branch with the largest diagonal term is chosen to avoid dividing by a small number.
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+    l3d_fxp_t m00 = m->m[0][0], m01 = m->m[0][1], m02 = m->m[0][2];
+    l3d_fxp_t m10 = m->m[1][0], m11 = m->m[1][1], m12 = m->m[1][2];
+    l3d_fxp_t m20 = m->m[2][0], m21 = m->m[2][1], m22 = m->m[2][2];
+    l3d_fxp_t one = l3d_floatToFixed(1.0f);
+    l3d_fxp_t trace = m00 + m11 + m22;
+    l3d_fxp_t s;
+    l3d_quat_t q;
+
+    if (trace > 0) {
+        s = l3d_fixedSqrt(trace + one) * 2;    // s = 4 * qw
+        q.w = s / 4;
+        q.x = l3d_fixedDiv(m21 - m12, s);
+        q.y = l3d_fixedDiv(m02 - m20, s);
+        q.z = l3d_fixedDiv(m10 - m01, s);
+    }
+    else if (m00 > m11 && m00 > m22) {
+        s = l3d_fixedSqrt(one + m00 - m11 - m22) * 2;    // s = 4 * qx
+        q.w = l3d_fixedDiv(m21 - m12, s);
+        q.x = s / 4;
+        q.y = l3d_fixedDiv(m01 + m10, s);
+        q.z = l3d_fixedDiv(m02 + m20, s);
+    }
+    else if (m11 > m22) {
+        s = l3d_fixedSqrt(one + m11 - m00 - m22) * 2;    // s = 4 * qy
+        q.w = l3d_fixedDiv(m02 - m20, s);
+        q.x = l3d_fixedDiv(m01 + m10, s);
+        q.y = s / 4;
+        q.z = l3d_fixedDiv(m12 + m21, s);
+    }
+    else {
+        s = l3d_fixedSqrt(one + m22 - m00 - m11) * 2;    // s = 4 * qz
+        q.w = l3d_fixedDiv(m10 - m01, s);
+        q.x = l3d_fixedDiv(m02 + m20, s);
+        q.y = l3d_fixedDiv(m12 + m21, s);
+        q.z = s / 4;
+    }
+
+    return q;
+#else
+    l3d_flp_t m00 = l3d_rationalToFloat(m->m[0][0]);
+    l3d_flp_t m01 = l3d_rationalToFloat(m->m[0][1]);
+    l3d_flp_t m02 = l3d_rationalToFloat(m->m[0][2]);
+    l3d_flp_t m10 = l3d_rationalToFloat(m->m[1][0]);
+    l3d_flp_t m11 = l3d_rationalToFloat(m->m[1][1]);
+    l3d_flp_t m12 = l3d_rationalToFloat(m->m[1][2]);
+    l3d_flp_t m20 = l3d_rationalToFloat(m->m[2][0]);
+    l3d_flp_t m21 = l3d_rationalToFloat(m->m[2][1]);
+    l3d_flp_t m22 = l3d_rationalToFloat(m->m[2][2]);
+    l3d_flp_t trace = m00 + m11 + m22;
+    l3d_flp_t s, qw, qx, qy, qz;
+
+    if (trace > 0.0f) {
+        s = sqrtf(trace + 1.0f) * 2.0f;    // s = 4 * qw
+        qw = 0.25f * s;
+        qx = (m21 - m12) / s;
+        qy = (m02 - m20) / s;
+        qz = (m10 - m01) / s;
+    }
+    else if (m00 > m11 && m00 > m22) {
+        s = sqrtf(1.0f + m00 - m11 - m22) * 2.0f;    // s = 4 * qx
+        qw = (m21 - m12) / s;
+        qx = 0.25f * s;
+        qy = (m01 + m10) / s;
+        qz = (m02 + m20) / s;
+    }
+    else if (m11 > m22) {
+        s = sqrtf(1.0f + m11 - m00 - m22) * 2.0f;    // s = 4 * qy
+        qw = (m02 - m20) / s;
+        qx = (m01 + m10) / s;
+        qy = 0.25f * s;
+        qz = (m12 + m21) / s;
+    }
+    else {
+        s = sqrtf(1.0f + m22 - m00 - m11) * 2.0f;    // s = 4 * qz
+        qw = (m10 - m01) / s;
+        qx = (m02 + m20) / s;
+        qy = (m12 + m21) / s;
+        qz = 0.25f * s;
+    }
+
+    return l3d_getQuatFromFloat(qw, qx, qy, qz);
+#endif  // L3D_USE_FIXED_POINT_ARITHMETIC
+}
+
+l3d_quat_t l3d_rotMatToQuat(const l3d_mat4x4_t *m) {
+    l3d_mat3x4_t affine;
+    l3d_mat3x4_fromMat4x4(&affine, m);
+    return l3d_affineToQuat(&affine);
+}
+
 l3d_quat_t l3d_axisAngleToQuat(const l3d_vec4_t *axis, l3d_rtnl_t angle_rad) {
     // Eq. 4ab-e from
     // https://danceswithcode.net/engineeringnotes/quaternions/quaternions.html
     l3d_quat_t q;
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
-    l3d_flp_t half_angle_flp = l3d_fixedToFloat(angle_rad) / 2.0f;
-    q.w = l3d_floatToFixed(cosf(half_angle_flp));
-    q.x = l3d_fixedMul(axis->x, l3d_floatToFixed(sinf(half_angle_flp)));
-    q.y = l3d_fixedMul(axis->y, l3d_floatToFixed(sinf(half_angle_flp)));
-    q.z = l3d_fixedMul(axis->z, l3d_floatToFixed(sinf(half_angle_flp)));
+    l3d_fxp_t sin_half_angle = l3d_fixedSin(angle_rad / 2);
+    q.w = l3d_fixedCos(angle_rad / 2);
+    q.x = l3d_fixedMul(axis->x, sin_half_angle);
+    q.y = l3d_fixedMul(axis->y, sin_half_angle);
+    q.z = l3d_fixedMul(axis->z, sin_half_angle);
 #else
     q.w = cosf(angle_rad / 2.0f);
     q.x = axis->x * sinf(angle_rad / 2.0f);
@@ -487,7 +896,7 @@ l3d_vec4_t l3d_vec4_crossProduct( const l3d_vec4_t *v1, const l3d_vec4_t *v2 ){
 
 l3d_rtnl_t l3d_vec4_length( const l3d_vec4_t *v ){
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
-    return l3d_floatToFixed( sqrt( l3d_fixedToFloat( l3d_vec4_dotProduct(v, v) ) ) );
+    return l3d_fixedSqrt( l3d_vec4_dotProduct(v, v) );
 #else
     return sqrtf( l3d_vec4_dotProduct(v, v) );
 #endif
@@ -498,14 +907,16 @@ bool l3d_vec4_isNormalised( const l3d_vec4_t *v ) {
 }
 
 l3d_vec4_t l3d_vec4_normalise( const l3d_vec4_t *v ){
-    l3d_rtnl_t l = l3d_vec4_length( v );
-#ifdef L3D_USE_FIXED_POINT_ARITHMETIC 
-    if( l == l3d_floatToFixed( 0.0f ) )
-        l = l3d_floatToFixed( 0.0001f );
-#endif
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
-    return (l3d_vec4_t){ l3d_fixedDiv( v->x, l ), l3d_fixedDiv( v->y, l), l3d_fixedDiv( v->z, l ), v->h };
+    // Multiply by 1 / length instead of dividing
+    uint64_t sq = (int64_t)v->x * v->x + (int64_t)v->y * v->y + (int64_t)v->z * v->z;
+    if( sq == 0 )
+        return *v;
+    uint8_t shift;
+    uint32_t r = invSqrtScale( sq, &shift );
+    return (l3d_vec4_t){ applyScale( v->x, r, shift ), applyScale( v->y, r, shift ), applyScale( v->z, r, shift ), v->h };
 #else
+    l3d_rtnl_t l = l3d_vec4_length( v );
     return (l3d_vec4_t){ v->x / l, v->y / l, v->z / l, v->h };
 #endif
 }
@@ -518,6 +929,48 @@ l3d_vec4_t l3d_vec4_negate( const l3d_vec4_t *v ) {
     return (l3d_vec4_t){-v->x, -v->y, -v->z, v->h};
 }
 
+// 
+// Plane operations
+// 
+
+// 
+// Scale plane coefficients so that its normal (a, b, c) has unit length.
+// Then l3d_plane_distanceToPoint() returns actual distance.
+// 
+l3d_plane_t l3d_plane_normalise( const l3d_plane_t *p ){
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+    uint64_t sq = (int64_t)p->a * p->a + (int64_t)p->b * p->b + (int64_t)p->c * p->c;
+    if( sq == 0 ){
+        L3D_DEBUG_PRINT( "Error: plane normal of length 0. Returining original plane.\n" );
+        return *p;
+    }
+    uint8_t shift;
+    uint32_t r = invSqrtScale( sq, &shift );
+    return (l3d_plane_t){ applyScale( p->a, r, shift ), applyScale( p->b, r, shift ), applyScale( p->c, r, shift ), applyScale( p->d, r, shift ) };
+#else
+    l3d_vec4_t n = { p->a, p->b, p->c, l3d_floatToRational(1.0f) };
+    l3d_rtnl_t l = l3d_vec4_length( &n );
+    if( l == l3d_floatToRational( 0.0f ) ){
+        L3D_DEBUG_PRINT( "Error: plane normal of length 0. Returining original plane.\n" );
+        return *p;
+    }
+    return (l3d_plane_t){ p->a / l, p->b / l, p->c / l, p->d / l };
+#endif
+}
+
+// 
+// Signed distance from point v to plane p
+// (positive in front of the plane).
+// Plane has to be normalised.
+// 
+l3d_rtnl_t l3d_plane_distanceToPoint( const l3d_plane_t *p, const l3d_vec4_t *v ){
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+    return l3d_fixedMul( p->a, v->x ) + l3d_fixedMul( p->b, v->y ) + l3d_fixedMul( p->c, v->z ) + p->d;
+#else
+    return p->a * v->x + p->b * v->y + p->c * v->z + p->d;
+#endif
+}
+
 l3d_quat_t l3d_quat_add(const l3d_quat_t *q1, const l3d_quat_t *q2) {
     return (l3d_quat_t){q1->w + q2->w, q1->x + q2->x, q1->y + q2->y, q1->z + q2->z};
 }
@@ -555,7 +1008,7 @@ l3d_rtnl_t l3d_quat_norm(const l3d_quat_t *q) {
     // Norm |q| = sqrt(q.w^2 + q.x^2 + q.y^2 + q.z^2)
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
     l3d_rtnl_t norm = l3d_fixedMul(q->w, q->w) + l3d_fixedMul(q->x, q->x) + l3d_fixedMul(q->y, q->y) + l3d_fixedMul(q->z, q->z);
-    norm = l3d_floatToFixed(sqrtf(l3d_fixedToFloat(norm)));
+    norm = l3d_fixedSqrt(norm);
 #else
     l3d_rtnl_t norm = sqrtf((q->w * q->w) + (q->x * q->x) + (q->y * q->y) + (q->z * q->z));
 #endif
@@ -571,11 +1024,15 @@ l3d_quat_t l3d_quat_normalise(const l3d_quat_t *q) {
     // L3D_DEBUG_PRINT_RTNL(norm);
 
     // Or simply
-    l3d_rtnl_t norm = l3d_quat_norm(q);
-
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
-    return (l3d_quat_t){ l3d_fixedDiv( q->w, norm ), l3d_fixedDiv( q->x, norm ), l3d_fixedDiv( q->y, norm), l3d_fixedDiv( q->z, norm ) };
+    uint64_t sq = (int64_t)q->w * q->w + (int64_t)q->x * q->x + (int64_t)q->y * q->y + (int64_t)q->z * q->z;
+    if( sq == 0 )
+        return *q;
+    uint8_t shift;
+    uint32_t r = invSqrtScale( sq, &shift );
+    return (l3d_quat_t){ applyScale( q->w, r, shift ), applyScale( q->x, r, shift ), applyScale( q->y, r, shift ), applyScale( q->z, r, shift ) };
 #else
+    l3d_rtnl_t norm = l3d_quat_norm(q);
     return (l3d_quat_t){ q->w / norm, q->x / norm, q->y / norm, q->z / norm };
 #endif
 }
@@ -644,6 +1101,400 @@ l3d_vec4_t l3d_mat4x4_mulVec4( const l3d_mat4x4_t *m, const l3d_vec4_t *v ){
 	return o;
 }
 
+// 
+// Batch vertex transformation.
+// All kernels give exactly the results of l3d_mat4x4_mulVec4()
+// and l3d_clipSpaceToScreenSpace(), so they can be mixed freely
+// with the single vertex functions.
+// 
+typedef void (*l3d_batchKernel_t)( const l3d_mat4x4_t *m, const l3d_vec4_t *in, l3d_vec4_t *out, l3d_index_t count, bool project );
+
+static void mulVec4ArrayPortable( const l3d_mat4x4_t *m, const l3d_vec4_t *in, l3d_vec4_t *out, l3d_index_t count, bool project ){
+    for( l3d_index_t i = 0; i < count; i++ ){
+        l3d_vec4_t o = l3d_mat4x4_mulVec4( m, &in[i] );
+        if( project )
+            l3d_clipSpaceToScreenSpace( &o );
+        out[i] = o;
+    }
+}
+
+#ifdef L3D_SIMD_X86
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+// 
+// l3d_fixedMul() of all four lanes: 32x32->64 bit products
+// of the even and odd lanes, shifted back and merged.
+// Logical shifts are fine, only the low 32 bits are kept.
+// 
+L3D_TARGET_SSE41 static inline __m128i fixedMulSse41( __m128i a, __m128i b ){
+    __m128i even = _mm_srli_epi64( _mm_mul_epi32( a, b ), L3D_FP_DP );
+    __m128i odd = _mm_srli_epi64( _mm_mul_epi32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) ), L3D_FP_DP );
+    return _mm_blend_epi16( even, _mm_slli_epi64( odd, 32 ), 0xCC );
+}
+
+L3D_TARGET_AVX2 static inline __m256i fixedMulAvx2( __m256i a, __m256i b ){
+    __m256i even = _mm256_srli_epi64( _mm256_mul_epi32( a, b ), L3D_FP_DP );
+    __m256i odd = _mm256_srli_epi64( _mm256_mul_epi32( _mm256_srli_epi64( a, 32 ), _mm256_srli_epi64( b, 32 ) ), L3D_FP_DP );
+    return _mm256_blend_epi16( even, _mm256_slli_epi64( odd, 32 ), 0xCC );
+}
+
+L3D_TARGET_SSE41 static void mulVec4ArraySse41( const l3d_mat4x4_t *m, const l3d_vec4_t *in, l3d_vec4_t *out, l3d_index_t count, bool project ){
+    __m128i r[4];
+    for( uint8_t i = 0; i < 4; i++ )
+        r[i] = _mm_loadu_si128( (const __m128i*)m->m[i] );
+
+    for( l3d_index_t i = 0; i < count; i++ ){
+        __m128i v = _mm_loadu_si128( (const __m128i*)&in[i] );
+        __m128i o = fixedMulSse41( _mm_shuffle_epi32( v, 0x00 ), r[0] );
+        o = _mm_add_epi32( o, fixedMulSse41( _mm_shuffle_epi32( v, 0x55 ), r[1] ) );
+        o = _mm_add_epi32( o, fixedMulSse41( _mm_shuffle_epi32( v, 0xAA ), r[2] ) );
+        o = _mm_add_epi32( o, fixedMulSse41( _mm_shuffle_epi32( v, 0xFF ), r[3] ) );
+        _mm_storeu_si128( (__m128i*)&out[i], o );
+        // There is no SIMD integer division, divide by w one by one
+        if( project )
+            l3d_clipSpaceToScreenSpace( &out[i] );
+    }
+}
+
+L3D_TARGET_AVX2 static void mulVec4ArrayAvx2( const l3d_mat4x4_t *m, const l3d_vec4_t *in, l3d_vec4_t *out, l3d_index_t count, bool project ){
+    __m256i r[4];
+    for( uint8_t i = 0; i < 4; i++ )
+        r[i] = _mm256_broadcastsi128_si256( _mm_loadu_si128( (const __m128i*)m->m[i] ) );
+
+    // Two vertices per register
+    l3d_index_t i = 0;
+    for( ; i + 1 < count; i += 2 ){
+        __m256i v = _mm256_loadu_si256( (const __m256i*)&in[i] );
+        __m256i o = fixedMulAvx2( _mm256_shuffle_epi32( v, 0x00 ), r[0] );
+        o = _mm256_add_epi32( o, fixedMulAvx2( _mm256_shuffle_epi32( v, 0x55 ), r[1] ) );
+        o = _mm256_add_epi32( o, fixedMulAvx2( _mm256_shuffle_epi32( v, 0xAA ), r[2] ) );
+        o = _mm256_add_epi32( o, fixedMulAvx2( _mm256_shuffle_epi32( v, 0xFF ), r[3] ) );
+        _mm256_storeu_si256( (__m256i*)&out[i], o );
+        if( project ){
+            l3d_clipSpaceToScreenSpace( &out[i] );
+            l3d_clipSpaceToScreenSpace( &out[i+1] );
+        }
+    }
+    if( i < count )
+        mulVec4ArraySse41( m, &in[i], &out[i], 1, project );
+}
+#else
+L3D_TARGET_SSE41 static inline __m128 mulVec4Sse41( __m128 v, const __m128 r[4] ){
+    // Same order of operations as l3d_mat4x4_mulVec4()
+    __m128 o = _mm_mul_ps( _mm_shuffle_ps( v, v, 0x00 ), r[0] );
+    o = _mm_add_ps( o, _mm_mul_ps( _mm_shuffle_ps( v, v, 0x55 ), r[1] ) );
+    o = _mm_add_ps( o, _mm_mul_ps( _mm_shuffle_ps( v, v, 0xAA ), r[2] ) );
+    o = _mm_add_ps( o, _mm_mul_ps( _mm_shuffle_ps( v, v, 0xFF ), r[3] ) );
+    return o;
+}
+
+// 
+// Store a vertex given in clip space, projecting it
+// the way l3d_clipSpaceToScreenSpace() does.
+// Corner cases (behind the near plane, w close to 0)
+// are left to l3d_clipSpaceToScreenSpace() itself.
+// 
+L3D_TARGET_SSE41 static inline void storeProjectedSse41( __m128 o, l3d_vec4_t *out ){
+    l3d_flp_t z = _mm_cvtss_f32( _mm_shuffle_ps( o, o, 0xAA ) );
+    l3d_flp_t h = _mm_cvtss_f32( _mm_shuffle_ps( o, o, 0xFF ) );
+
+    if( z >= 0.0f && fabsf( h ) >= L3D_EPSILON_RTNL ){
+        const __m128 sign = _mm_setr_ps( 1.0f, 1.0f, -1.0f, 1.0f );
+        const __m128 offset = _mm_setr_ps( 1.0f, 1.0f, 0.0f, 0.0f );
+        const __m128 scale = _mm_setr_ps( 0.5f * (l3d_flp_t)SCREEN_WIDTH, 0.5f * (l3d_flp_t)SCREEN_HEIGHT, 1.0f, 1.0f );
+
+        __m128 p = _mm_div_ps( o, _mm_set1_ps( h ) );
+        p = _mm_mul_ps( _mm_add_ps( _mm_mul_ps( p, sign ), offset ), scale );
+        // Keep the positive clip space w in h
+        p = _mm_blend_ps( p, _mm_set1_ps( -h ), 0x8 );
+        _mm_storeu_ps( &out->x, p );
+    }
+    else {
+        _mm_storeu_ps( &out->x, o );
+        l3d_clipSpaceToScreenSpace( out );
+    }
+}
+
+L3D_TARGET_SSE41 static void mulVec4ArraySse41( const l3d_mat4x4_t *m, const l3d_vec4_t *in, l3d_vec4_t *out, l3d_index_t count, bool project ){
+    __m128 r[4];
+    for( uint8_t i = 0; i < 4; i++ )
+        r[i] = _mm_loadu_ps( m->m[i] );
+
+    for( l3d_index_t i = 0; i < count; i++ ){
+        __m128 o = mulVec4Sse41( _mm_loadu_ps( &in[i].x ), r );
+        if( project )
+            storeProjectedSse41( o, &out[i] );
+        else
+            _mm_storeu_ps( &out[i].x, o );
+    }
+}
+
+L3D_TARGET_AVX2 static void mulVec4ArrayAvx2( const l3d_mat4x4_t *m, const l3d_vec4_t *in, l3d_vec4_t *out, l3d_index_t count, bool project ){
+    __m256 r[4];
+    for( uint8_t i = 0; i < 4; i++ )
+        r[i] = _mm256_broadcast_ps( (const __m128*)m->m[i] );
+
+    // Two vertices per register
+    l3d_index_t i = 0;
+    for( ; i + 1 < count; i += 2 ){
+        __m256 v = _mm256_loadu_ps( &in[i].x );
+        __m256 o = _mm256_mul_ps( _mm256_shuffle_ps( v, v, 0x00 ), r[0] );
+        o = _mm256_add_ps( o, _mm256_mul_ps( _mm256_shuffle_ps( v, v, 0x55 ), r[1] ) );
+        o = _mm256_add_ps( o, _mm256_mul_ps( _mm256_shuffle_ps( v, v, 0xAA ), r[2] ) );
+        o = _mm256_add_ps( o, _mm256_mul_ps( _mm256_shuffle_ps( v, v, 0xFF ), r[3] ) );
+        if( project ){
+            storeProjectedSse41( _mm256_castps256_ps128( o ), &out[i] );
+            storeProjectedSse41( _mm256_extractf128_ps( o, 1 ), &out[i+1] );
+        }
+        else
+            _mm256_storeu_ps( &out[i].x, o );
+    }
+    if( i < count )
+        mulVec4ArraySse41( m, &in[i], &out[i], 1, project );
+}
+#endif  // L3D_USE_FIXED_POINT_ARITHMETIC
+#endif  // L3D_SIMD_X86
+
+#ifdef L3D_SIMD_X86
+static l3d_batchKernel_t selectBatchKernel( void ){
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "avx2" ) )
+        return mulVec4ArrayAvx2;
+    if( __builtin_cpu_supports( "sse4.1" ) )
+        return mulVec4ArraySse41;
+    return mulVec4ArrayPortable;
+}
+
+// 
+// Chosen on first use. Threads rendering at the same time may choose it
+// more than once, but they all get the same kernel, so an atomic store is enough.
+// 
+static _Atomic( l3d_batchKernel_t ) l3d_batchKernel = NULL;
+
+static void mulVec4ArrayDispatch( const l3d_mat4x4_t *m, const l3d_vec4_t *in, l3d_vec4_t *out, l3d_index_t count, bool project ){
+    l3d_batchKernel_t kernel = atomic_load_explicit( &l3d_batchKernel, memory_order_relaxed );
+    if( kernel == NULL ){
+        kernel = selectBatchKernel();
+        atomic_store_explicit( &l3d_batchKernel, kernel, memory_order_relaxed );
+    }
+    kernel( m, in, out, count, project );
+}
+#else
+static void mulVec4ArrayDispatch( const l3d_mat4x4_t *m, const l3d_vec4_t *in, l3d_vec4_t *out, l3d_index_t count, bool project ){
+    mulVec4ArrayPortable( m, in, out, count, project );
+}
+#endif
+
+void l3d_mat4x4_mulVec4Array( const l3d_mat4x4_t *m, const l3d_vec4_t *in, l3d_vec4_t *out, l3d_index_t count ){
+    mulVec4ArrayDispatch( m, in, out, count, false );
+}
+
+void l3d_mat4x4_projectVec4Array( const l3d_mat4x4_t *m, const l3d_vec4_t *in, l3d_vec4_t *out, l3d_index_t count ){
+    mulVec4ArrayDispatch( m, in, out, count, true );
+}
+
+// 
+// Affine matrix operations.
+// The last column of l3d_mat4x4_t is left out, it is always (0, 0, 0, 1),
+// so the results are exactly those of the 4x4 functions.
+// 
+
+void l3d_mat3x4_makeIdentity( l3d_mat3x4_t *m ){
+    memset( m->m, l3d_floatToRational(0.0f), sizeof( m->m ) );
+
+    m->m[0][0] = l3d_floatToRational(1.0f);
+    m->m[1][1] = l3d_floatToRational(1.0f);
+    m->m[2][2] = l3d_floatToRational(1.0f);
+}
+
+void l3d_mat3x4_fromMat4x4( l3d_mat3x4_t *m_out, const l3d_mat4x4_t *m ){
+    for( uint8_t r = 0; r < 4; r++ )
+        for( uint8_t c = 0; c < 3; c++ )
+            m_out->m[r][c] = m->m[r][c];
+}
+
+void l3d_mat3x4_toMat4x4( l3d_mat4x4_t *m_out, const l3d_mat3x4_t *m ){
+    for( uint8_t r = 0; r < 4; r++ ){
+        for( uint8_t c = 0; c < 3; c++ )
+            m_out->m[r][c] = m->m[r][c];
+        m_out->m[r][3] = l3d_floatToRational(0.0f);
+    }
+    m_out->m[3][3] = l3d_floatToRational(1.0f);
+}
+
+// 
+// 9 multiplications for points (h = 1), 12 otherwise,
+// instead of 16 with l3d_mat4x4_mulVec4()
+// 
+l3d_vec4_t l3d_mat3x4_mulVec4( const l3d_mat3x4_t *m, const l3d_vec4_t *v ){
+    l3d_vec4_t o;
+    l3d_rtnl_t tx = m->m[3][0], ty = m->m[3][1], tz = m->m[3][2];
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+    if( v->h != l3d_floatToFixed( 1.0f ) ){
+        tx = l3d_fixedMul( v->h, tx );
+        ty = l3d_fixedMul( v->h, ty );
+        tz = l3d_fixedMul( v->h, tz );
+    }
+    o.x = l3d_fixedMul( v->x, m->m[0][0] ) + l3d_fixedMul( v->y, m->m[1][0] ) + l3d_fixedMul( v->z, m->m[2][0] ) + tx;
+    o.y = l3d_fixedMul( v->x, m->m[0][1] ) + l3d_fixedMul( v->y, m->m[1][1] ) + l3d_fixedMul( v->z, m->m[2][1] ) + ty;
+    o.z = l3d_fixedMul( v->x, m->m[0][2] ) + l3d_fixedMul( v->y, m->m[1][2] ) + l3d_fixedMul( v->z, m->m[2][2] ) + tz;
+#else
+    if( v->h != 1.0f ){
+        tx = v->h * tx;
+        ty = v->h * ty;
+        tz = v->h * tz;
+    }
+    o.x = v->x * m->m[0][0] + v->y * m->m[1][0] + v->z * m->m[2][0] + tx;
+    o.y = v->x * m->m[0][1] + v->y * m->m[1][1] + v->z * m->m[2][1] + ty;
+    o.z = v->x * m->m[0][2] + v->y * m->m[1][2] + v->z * m->m[2][2] + tz;
+#endif
+    o.h = v->h;
+    return o;
+}
+
+void l3d_mat3x4_mulVec4Array( const l3d_mat3x4_t *m, const l3d_vec4_t *in, l3d_vec4_t *out, l3d_index_t count ){
+#ifdef L3D_SIMD_X86
+    // The vector kernels get the 4th column for free
+    l3d_mat4x4_t m4;
+    l3d_mat3x4_toMat4x4( &m4, m );
+    mulVec4ArrayDispatch( &m4, in, out, count, false );
+#else
+    for( l3d_index_t i = 0; i < count; i++ )
+        out[i] = l3d_mat3x4_mulVec4( m, &in[i] );
+#endif
+}
+
+// 
+// Gives the same results as l3d_mat3x4_mulVec4() with h = 1,
+// but writes each coordinate into its own array,
+// which leaves the loops easy to vectorise.
+// 
+void l3d_mat3x4_mulPointStreams( const l3d_mat3x4_t *m, const l3d_rtnl_t *in_xyz, l3d_rtnl_t *out_x, l3d_rtnl_t *out_y, l3d_rtnl_t *out_z, l3d_index_t count ){
+    l3d_rtnl_t *out[3] = { out_x, out_y, out_z };
+    for( uint8_t c = 0; c < 3; c++ ){
+        l3d_rtnl_t m0 = m->m[0][c], m1 = m->m[1][c], m2 = m->m[2][c], m3 = m->m[3][c];
+        l3d_rtnl_t *o = out[c];
+        for( l3d_index_t i = 0; i < count; i++ ){
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+            o[i] = l3d_fixedMul( in_xyz[i*3+0], m0 ) + l3d_fixedMul( in_xyz[i*3+1], m1 ) + l3d_fixedMul( in_xyz[i*3+2], m2 ) + m3;
+#else
+            o[i] = in_xyz[i*3+0] * m0 + in_xyz[i*3+1] * m1 + in_xyz[i*3+2] * m2 + m3;
+#endif
+        }
+    }
+}
+
+#ifdef L3D_USE_QUANTISED_VERTICES
+void l3d_mat3x4q_fromMat3x4( l3d_mat3x4q_t *m_out, const l3d_mat3x4_t *m, const l3d_vert_quant_t *quant ){
+    for( uint8_t r = 0; r < 3; r++ )
+        for( uint8_t c = 0; c < 3; c++ ){
+            // Rational -> Q1.14, rounded; |m| may exceed 1 by the rounding of the quaternion
+#if L3D_FP_DP > 14
+            int32_t e = ( m->m[r][c] + ( 1 << ( L3D_FP_DP - 15 ) ) ) >> ( L3D_FP_DP - 14 );
+#else
+            int32_t e = m->m[r][c] * ( 1 << ( 14 - L3D_FP_DP ) );
+#endif
+            m_out->m[r][c] = (int16_t)( e > 16384 ? 16384 : ( e < -16384 ? -16384 : e ) );
+        }
+    // Once per object, so the 64 bit products do not matter
+    for( uint8_t c = 0; c < 3; c++ )
+        m_out->t[c] = l3d_fixedMul( quant->offset[0], m->m[0][c] ) + l3d_fixedMul( quant->offset[1], m->m[1][c] ) +
+                      l3d_fixedMul( quant->offset[2], m->m[2][c] ) + m->m[3][c];
+    // q * 2^shift * Q1.14 -> rational
+    m_out->shift = 14 - quant->shift;
+}
+
+// 
+// Coordinate c of a quantised vertex transformed by m.
+// |q| <= 32767 and |m| <= 16384, so the sum of three products fits 32 bits.
+// 
+static inline l3d_rtnl_t mulQuantVertex( const l3d_mat3x4q_t *m, const int16_t *q, uint8_t c ){
+    int32_t acc = (int32_t)q[0] * m->m[0][c] + (int32_t)q[1] * m->m[1][c] + (int32_t)q[2] * m->m[2][c];
+    return ( ( acc + ( ( 1 << m->shift ) >> 1 ) ) >> m->shift ) + m->t[c];
+}
+
+void l3d_mat3x4q_mulVertexArray( const l3d_mat3x4q_t *m, const int16_t *in_xyz, l3d_vec4_t *out, l3d_index_t count ){
+    for( l3d_index_t i = 0; i < count; i++ ){
+        const int16_t *q = &in_xyz[i*3];
+        out[i] = (l3d_vec4_t){ mulQuantVertex( m, q, 0 ), mulQuantVertex( m, q, 1 ), mulQuantVertex( m, q, 2 ), l3d_floatToRational(1.0f) };
+    }
+}
+
+void l3d_mat3x4q_mulPointStreams( const l3d_mat3x4q_t *m, const int16_t *in_xyz, l3d_rtnl_t *out_x, l3d_rtnl_t *out_y, l3d_rtnl_t *out_z, l3d_index_t count ){
+    for( l3d_index_t i = 0; i < count; i++ ){
+        const int16_t *q = &in_xyz[i*3];
+        out_x[i] = mulQuantVertex( m, q, 0 );
+        out_y[i] = mulQuantVertex( m, q, 1 );
+        out_z[i] = mulQuantVertex( m, q, 2 );
+    }
+}
+
+l3d_vec4_t l3d_dequantiseVertex( const int16_t *q, const l3d_vert_quant_t *quant ){
+    return (l3d_vec4_t){
+        quant->offset[0] + q[0] * ( (int32_t)1 << quant->shift ),
+        quant->offset[1] + q[1] * ( (int32_t)1 << quant->shift ),
+        quant->offset[2] + q[2] * ( (int32_t)1 << quant->shift ),
+        l3d_floatToRational(1.0f)
+    };
+}
+#endif  // L3D_USE_QUANTISED_VERTICES
+
+// 
+// m1 followed by m2, 36 multiplications instead of 64
+// 
+void l3d_mat3x4_mulMatrix( l3d_mat3x4_t *m_out, const l3d_mat3x4_t *m1, const l3d_mat3x4_t *m2 ){
+    for (int c = 0; c < 3; c++)
+        for (int r = 0; r < 4; r++){
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+            m_out->m[r][c] = l3d_fixedMul( m1->m[r][0], m2->m[0][c] ) + l3d_fixedMul( m1->m[r][1], m2->m[1][c] ) + l3d_fixedMul( m1->m[r][2], m2->m[2][c] );
+#else
+            m_out->m[r][c] = m1->m[r][0] * m2->m[0][c] + m1->m[r][1] * m2->m[1][c] + m1->m[r][2] * m2->m[2][c];
+#endif
+            if( r == 3 )
+                m_out->m[r][c] += m2->m[3][c];
+        }
+}
+
+// 
+// Affine m1 followed by a general m2 (e.g. view * projection),
+// 48 multiplications instead of 64
+// 
+void l3d_mat3x4_mulMat4x4( l3d_mat4x4_t *m_out, const l3d_mat3x4_t *m1, const l3d_mat4x4_t *m2 ){
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 4; r++){
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+            m_out->m[r][c] = l3d_fixedMul( m1->m[r][0], m2->m[0][c] ) + l3d_fixedMul( m1->m[r][1], m2->m[1][c] ) + l3d_fixedMul( m1->m[r][2], m2->m[2][c] );
+#else
+            m_out->m[r][c] = m1->m[r][0] * m2->m[0][c] + m1->m[r][1] * m2->m[1][c] + m1->m[r][2] * m2->m[2][c];
+#endif
+            if( r == 3 )
+                m_out->m[r][c] += m2->m[3][c];
+        }
+}
+
+// 
+// Viewport transform folded into a projection matrix m
+// whose clip space w is always -1 (l3d_mat4x4_makeOrthographic(),
+// possibly preceded by affine matrices). Vertices transformed
+// by m_out get the x, y and z l3d_clipSpaceToScreenSpace() would give
+// and keep h = 1, the perspective divide is not needed.
+// 
+void l3d_mat3x4_makeScreenTransform( l3d_mat3x4_t *m_out, const l3d_mat4x4_t *m ){
+    // x / w = -x, z is negated back by l3d_clipSpaceToScreenSpace()
+    for (int r = 0; r < 4; r++){
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+        m_out->m[r][0] = l3d_fixedMul( -m->m[r][0], l3d_floatToFixed(0.5f * (l3d_flp_t)SCREEN_WIDTH) );
+        m_out->m[r][1] = l3d_fixedMul( -m->m[r][1], l3d_floatToFixed(0.5f * (l3d_flp_t)SCREEN_HEIGHT) );
+#else
+        m_out->m[r][0] = -m->m[r][0] * 0.5f * (l3d_flp_t)SCREEN_WIDTH;
+        m_out->m[r][1] = -m->m[r][1] * 0.5f * (l3d_flp_t)SCREEN_HEIGHT;
+#endif
+        m_out->m[r][2] = m->m[r][2];
+    }
+    // Offset of the viewport
+    m_out->m[3][0] += l3d_floatToRational(0.5f * (l3d_flp_t)SCREEN_WIDTH);
+    m_out->m[3][1] += l3d_floatToRational(0.5f * (l3d_flp_t)SCREEN_HEIGHT);
+}
+
 void l3d_mat4x4_makeEmpty( l3d_mat4x4_t *m ){
     memset( m->m, l3d_floatToRational(0.0f), sizeof( m->m ) );
 }
@@ -660,10 +1511,10 @@ void l3d_mat4x4_makeIdentity( l3d_mat4x4_t *m ){
 void l3d_mat4x4_makeRotZ( l3d_mat4x4_t *m, l3d_rtnl_t angle_rad ){
 	l3d_mat4x4_makeEmpty( m );
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
-    m->m[0][0] = l3d_floatToFixed( cosf( l3d_fixedToFloat( angle_rad ) ) );
-    m->m[0][1] = l3d_floatToFixed( -sinf( l3d_fixedToFloat( angle_rad ) ) );
-    m->m[1][0] = l3d_floatToFixed( sinf( l3d_fixedToFloat( angle_rad ) ) );
-    m->m[1][1] = l3d_floatToFixed( cosf( l3d_fixedToFloat( angle_rad ) ) );
+    m->m[0][0] = l3d_fixedCos( angle_rad );
+    m->m[0][1] = -l3d_fixedSin( angle_rad );
+    m->m[1][0] = l3d_fixedSin( angle_rad );
+    m->m[1][1] = l3d_fixedCos( angle_rad );
     m->m[2][2] = l3d_floatToFixed( 1.0f );
     m->m[3][3] = l3d_floatToFixed( 1.0f );
 #else
@@ -680,10 +1531,10 @@ void l3d_mat4x4_makeRotX( l3d_mat4x4_t *m, l3d_rtnl_t angle_rad ){
 	l3d_mat4x4_makeEmpty( m );
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
     m->m[0][0] = l3d_floatToFixed( 1.0f );
-    m->m[1][1] = l3d_floatToFixed( cosf( l3d_fixedToFloat( angle_rad ) ) );
-    m->m[1][2] = l3d_floatToFixed( -sinf( l3d_fixedToFloat( angle_rad ) ) );
-    m->m[2][1] = l3d_floatToFixed( sinf( l3d_fixedToFloat( angle_rad ) ) );
-    m->m[2][2] = l3d_floatToFixed( cosf( l3d_fixedToFloat( angle_rad ) ) );
+    m->m[1][1] = l3d_fixedCos( angle_rad );
+    m->m[1][2] = -l3d_fixedSin( angle_rad );
+    m->m[2][1] = l3d_fixedSin( angle_rad );
+    m->m[2][2] = l3d_fixedCos( angle_rad );
     m->m[3][3] = l3d_floatToFixed( 1.0f );
 #else
     m->m[0][0] = 1.0f;
@@ -698,11 +1549,11 @@ void l3d_mat4x4_makeRotX( l3d_mat4x4_t *m, l3d_rtnl_t angle_rad ){
 void l3d_mat4x4_makeRotY( l3d_mat4x4_t *m, l3d_rtnl_t angle_rad){
     l3d_mat4x4_makeEmpty( m );
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
-    m->m[0][0] = l3d_floatToFixed( cosf( l3d_fixedToFloat( angle_rad ) ) );
-	m->m[0][2] = l3d_floatToFixed( sinf( l3d_fixedToFloat( angle_rad ) ) );
-	m->m[2][0] = l3d_floatToFixed( -sinf( l3d_fixedToFloat( angle_rad ) ) );
+    m->m[0][0] = l3d_fixedCos( angle_rad );
+	m->m[0][2] = l3d_fixedSin( angle_rad );
+	m->m[2][0] = -l3d_fixedSin( angle_rad );
 	m->m[1][1] = l3d_floatToFixed( 1.0f );
-	m->m[2][2] = l3d_floatToFixed( cosf( l3d_fixedToFloat( angle_rad ) ) );
+	m->m[2][2] = l3d_fixedCos( angle_rad );
 	m->m[3][3] = l3d_floatToFixed( 1.0f );
 #else
 	m->m[0][0] = cosf(angle_rad);
@@ -724,10 +1575,10 @@ void l3d_mat4x4_makeRotY( l3d_mat4x4_t *m, l3d_rtnl_t angle_rad){
 // angle_rad - angle in radians
 // 
 void l3d_mat4x4_makeRot( l3d_mat4x4_t *m, const l3d_vec4_t *u, l3d_rtnl_t angle_rad) {
-    l3d_rtnl_t sin_theta = l3d_floatToRational( sinf( l3d_rationalToFloat(angle_rad) ) );
-    l3d_rtnl_t cos_theta = l3d_floatToRational( cosf( l3d_rationalToFloat(angle_rad) ) );
-
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+    l3d_rtnl_t sin_theta = l3d_fixedSin(angle_rad);
+    l3d_rtnl_t cos_theta = l3d_fixedCos(angle_rad);
+
     l3d_rtnl_t ux2 = l3d_fixedMul(u->x, u->x);
     l3d_rtnl_t uy2 = l3d_fixedMul(u->y, u->y);
     l3d_rtnl_t uz2 = l3d_fixedMul(u->z, u->z);
@@ -761,6 +1612,9 @@ void l3d_mat4x4_makeRot( l3d_mat4x4_t *m, const l3d_vec4_t *u, l3d_rtnl_t angle_
     m->m[3][2] = l3d_floatToRational(0.0f);
     m->m[3][3] = l3d_floatToRational(1.0f);
 #else
+    l3d_rtnl_t sin_theta = sinf(angle_rad);
+    l3d_rtnl_t cos_theta = cosf(angle_rad);
+
     l3d_rtnl_t ux2 = u->x * u->x;
     l3d_rtnl_t uy2 = u->y * u->y;
     l3d_rtnl_t uz2 = u->z * u->z;
@@ -824,6 +1678,14 @@ bool l3d_mat4x4_getEulerAngles( const l3d_mat4x4_t *m, l3d_rot_t *rot ) {
     // rot->roll = l3d_floatToRational( atan2f( l3d_rationalToFloat(m->m[2][1]), l3d_rationalToFloat(m->m[2][2]) ) );
     // return false;
 
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+    rot->yaw = l3d_fixedAtan2(m->m[2][1], m->m[2][2]);
+
+    l3d_rtnl_t sin_pitch = -m->m[2][0];
+    rot->pitch = l3d_fixedAsin(sin_pitch);
+
+    rot->roll = l3d_fixedAtan2(m->m[1][0], m->m[0][0]);
+#else
     // Extract yaw (Z-axis rotation)
     rot->yaw = l3d_floatToRational( atan2f( l3d_rationalToFloat(m->m[2][1]), l3d_rationalToFloat(m->m[2][2]) ) );
 
@@ -839,6 +1701,7 @@ bool l3d_mat4x4_getEulerAngles( const l3d_mat4x4_t *m, l3d_rot_t *rot ) {
 
     // Extract roll (Y-axis rotation)
     rot->roll = atan2f(m->m[1][0], m->m[0][0]);
+#endif
 
     return false;
 }
@@ -858,8 +1721,9 @@ void l3d_mat4x4_makeTranslation( l3d_mat4x4_t *m, const l3d_vec4_t *delta_pos ){
 void l3d_mat4x4_makeProjection( l3d_mat4x4_t *m, l3d_rtnl_t fov_degrees, l3d_rtnl_t aspect_ratio, l3d_rtnl_t near_plane, l3d_rtnl_t far_plane ){
     l3d_mat4x4_makeEmpty( m );
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
-    // Fov coefficient in radians
-    l3d_rtnl_t fov_rad = l3d_fixedDiv( l3d_floatToFixed( 1.0f ), l3d_floatToFixed( tanf( l3d_fixedToFloat( fov_degrees ) * 0.5f / 180.0f * M_PI ) ) );
+    // Fov coefficient in radians, cot(fov / 2)
+    l3d_rtnl_t half_fov_rad = l3d_fixedMul( fov_degrees, l3d_floatToFixed( 0.5f / 180.0f * M_PI ) );
+    l3d_rtnl_t fov_rad = l3d_fixedDiv( l3d_fixedCos( half_fov_rad ), l3d_fixedSin( half_fov_rad ) );
     
     m->m[0][0] = l3d_fixedMul( aspect_ratio, fov_rad );
     m->m[1][1] = fov_rad;
@@ -884,6 +1748,31 @@ void l3d_mat4x4_makeProjection( l3d_mat4x4_t *m, l3d_rtnl_t fov_degrees, l3d_rtn
 #endif
 }
 
+// 
+// Orthographic projection, same conventions as l3d_mat4x4_makeProjection(),
+// but clip space w is always -1 instead of -z.
+// height - height of the view volume in world units
+// 
+void l3d_mat4x4_makeOrthographic( l3d_mat4x4_t *m, l3d_rtnl_t height, l3d_rtnl_t aspect_ratio, l3d_rtnl_t near_plane, l3d_rtnl_t far_plane ){
+    l3d_mat4x4_makeEmpty( m );
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+    l3d_rtnl_t scale = l3d_fixedDiv( l3d_floatToFixed( 2.0f ), height );
+
+    m->m[0][0] = l3d_fixedMul( aspect_ratio, scale );
+    m->m[1][1] = scale;
+    m->m[2][2] = l3d_fixedDiv( l3d_floatToFixed( 1.0f ), ( far_plane - near_plane ) );
+    m->m[3][2] = l3d_fixedDiv( -near_plane, ( far_plane - near_plane ) );
+#else
+    l3d_rtnl_t scale = 2.0f / height;
+
+    m->m[0][0] = aspect_ratio * scale;
+    m->m[1][1] = scale;
+    m->m[2][2] = 1.0f / ( far_plane - near_plane );
+    m->m[3][2] = -near_plane / ( far_plane - near_plane );
+#endif
+    m->m[3][3] = l3d_floatToRational( -1.0f );
+}
+
 void l3d_mat4x4_mulMatrix( l3d_mat4x4_t *m_out, const l3d_mat4x4_t *m1, const l3d_mat4x4_t *m2 ){
     for (int c = 0; c < 4; c++)
 		for (int r = 0; r < 4; r++)
@@ -894,11 +1783,53 @@ void l3d_mat4x4_mulMatrix( l3d_mat4x4_t *m_out, const l3d_mat4x4_t *m1, const l3
 #endif
 }
 
+static l3d_plane_t addPlaneCoeffs( const l3d_plane_t *p1, const l3d_plane_t *p2 ){
+    return (l3d_plane_t){ p1->a + p2->a, p1->b + p2->b, p1->c + p2->c, p1->d + p2->d };
+}
+
+static l3d_plane_t subPlaneCoeffs( const l3d_plane_t *p1, const l3d_plane_t *p2 ){
+    return (l3d_plane_t){ p1->a - p2->a, p1->b - p2->b, p1->c - p2->c, p1->d - p2->d };
+}
+
+// 
+// Extract frustum planes from given view * projection matrix
+// (Gribb & Hartmann method, adapted to row vectors: v * m).
+// Planes are normalised and face the inside of the frustum.
+// 
+// The projection matrix yields negative w in front of the camera
+// (see l3d_mat4x4_makeProjection()), so the inside of the frustum is:
+//  -w' <= x <= w',  -w' <= y <= w',  0 <= z <= w',  where w' = -w
+// 
+// depth_range - far plane distance - near plane distance
+// The far plane is made from the near one, because extracting it
+// from the matrix loses all precision with fixed point arithmetic
+// (its normal is scaled by near / (far - near)).
+// 
+void l3d_mat4x4_getFrustumPlanes( l3d_plane_t planes[6], const l3d_mat4x4_t *m, l3d_rtnl_t depth_range ){
+    // Columns of the matrix give clip space coordinates as functions of (x, y, z, 1)
+    l3d_plane_t col_x = { m->m[0][0], m->m[1][0], m->m[2][0], m->m[3][0] };
+    l3d_plane_t col_y = { m->m[0][1], m->m[1][1], m->m[2][1], m->m[3][1] };
+    l3d_plane_t col_z = { m->m[0][2], m->m[1][2], m->m[2][2], m->m[3][2] };
+    l3d_plane_t col_w = { -m->m[0][3], -m->m[1][3], -m->m[2][3], -m->m[3][3] };   // w' = -w
+
+    planes[0] = addPlaneCoeffs( &col_w, &col_x );   // left
+    planes[1] = subPlaneCoeffs( &col_w, &col_x );   // right
+    planes[2] = addPlaneCoeffs( &col_w, &col_y );   // bottom
+    planes[3] = subPlaneCoeffs( &col_w, &col_y );   // top
+    planes[4] = col_z;                              // near
+
+    for( uint8_t i = 0; i < 5; i++ )
+        planes[i] = l3d_plane_normalise( &planes[i] );
+
+    // Far plane: facing the opposite way, depth_range further
+    planes[5] = (l3d_plane_t){ -planes[4].a, -planes[4].b, -planes[4].c, depth_range - planes[4].d };
+}
+
 #ifdef L3D_CAMERA_MOVABLE
 //  pos - where the object should be
 //  target - "forward" vector for that object
 //  up - "up" vector
-void l3d_mat4x4_pointAt( l3d_mat4x4_t *m_out, const l3d_vec4_t *pos, const l3d_vec4_t *target, const l3d_vec4_t *up ){
+void l3d_mat3x4_pointAt( l3d_mat3x4_t *m_out, const l3d_vec4_t *pos, const l3d_vec4_t *target, const l3d_vec4_t *up ){
     // Calculate new forward direction:
     // Z-axis
     l3d_vec4_t newForward = l3d_vec4_sub( target, pos );
@@ -939,10 +1870,10 @@ void l3d_mat4x4_pointAt( l3d_mat4x4_t *m_out, const l3d_vec4_t *pos, const l3d_v
    neye.z = -pos->z;
 
     // Construct Dimensioning and Translation Matrix	
-    m_out->m[0][0] = newRight.x;	    m_out->m[0][1] = newRight.y;	    m_out->m[0][2] = newRight.z;	    m_out->m[0][3] = l3d_floatToRational(0.0f);
-	m_out->m[1][0] = newUp.x;		    m_out->m[1][1] = newUp.y;		    m_out->m[1][2] = newUp.z;		    m_out->m[1][3] = l3d_floatToRational(0.0f);
-	m_out->m[2][0] = newForward.x;	    m_out->m[2][1] = newForward.y;	    m_out->m[2][2] = newForward.z;	    m_out->m[2][3] = l3d_floatToRational(0.0f);
-	m_out->m[3][0] = pos->x;			m_out->m[3][1] = pos->y;			m_out->m[3][2] = pos->z;			m_out->m[3][3] = l3d_floatToRational(1.0f);
+    m_out->m[0][0] = newRight.x;	    m_out->m[0][1] = newRight.y;	    m_out->m[0][2] = newRight.z;
+	m_out->m[1][0] = newUp.x;		    m_out->m[1][1] = newUp.y;		    m_out->m[1][2] = newUp.z;
+	m_out->m[2][0] = newForward.x;	    m_out->m[2][1] = newForward.y;	    m_out->m[2][2] = newForward.z;
+	m_out->m[3][0] = pos->x;			m_out->m[3][1] = pos->y;			m_out->m[3][2] = pos->z;
 
 }
 
@@ -951,73 +1882,224 @@ void l3d_mat4x4_lookAtRH( l3d_mat4x4_t *m_out, l3d_vec4_t *eye, l3d_vec4_t *targ
 void l3d_mat4x4_lookAtLH( l3d_mat4x4_t *m_out, l3d_vec4_t *eye, l3d_vec4_t *target, l3d_vec4_t *up );
 void l3d_mat4x4_FPS( l3d_mat4x4_t *m_out, l3d_vec4_t *pos, l3d_rtnl_t pitch, l3d_rtnl_t yaw );
 
-// Works only for Rotation/Translation Matrices
-void l3d_mat4x4_quickInverse( l3d_mat4x4_t *m_out, const l3d_mat4x4_t *m ){
-    l3d_mat4x4_makeEmpty( m_out );
+// Works only for Rotation/Translation Matrices:
+// the rotation part is transposed, the translation rotated back
+void l3d_mat3x4_quickInverse( l3d_mat3x4_t *m_out, const l3d_mat3x4_t *m ){
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
-	m_out->m[0][0] = m->m[0][0]; m_out->m[0][1] = m->m[1][0]; m_out->m[0][2] = m->m[2][0]; m_out->m[0][3] = l3d_floatToFixed(0.0f);
-	m_out->m[1][0] = m->m[0][1]; m_out->m[1][1] = m->m[1][1]; m_out->m[1][2] = m->m[2][1]; m_out->m[1][3] = l3d_floatToFixed(0.0f);
-	m_out->m[2][0] = m->m[0][2]; m_out->m[2][1] = m->m[1][2]; m_out->m[2][2] = m->m[2][2]; m_out->m[2][3] = l3d_floatToFixed(0.0f);
+	m_out->m[0][0] = m->m[0][0]; m_out->m[0][1] = m->m[1][0]; m_out->m[0][2] = m->m[2][0];
+	m_out->m[1][0] = m->m[0][1]; m_out->m[1][1] = m->m[1][1]; m_out->m[1][2] = m->m[2][1];
+	m_out->m[2][0] = m->m[0][2]; m_out->m[2][1] = m->m[1][2]; m_out->m[2][2] = m->m[2][2];
     m_out->m[3][0] = -( l3d_fixedMul( m->m[3][0], m_out->m[0][0] ) + l3d_fixedMul( m->m[3][1], m_out->m[1][0] ) + l3d_fixedMul( m->m[3][2], m_out->m[2][0] ) );
     m_out->m[3][1] = -( l3d_fixedMul( m->m[3][0], m_out->m[0][1] ) + l3d_fixedMul( m->m[3][1], m_out->m[1][1] ) + l3d_fixedMul( m->m[3][2], m_out->m[2][1] ) );
     m_out->m[3][2] = -( l3d_fixedMul( m->m[3][0], m_out->m[0][2] ) + l3d_fixedMul( m->m[3][1], m_out->m[1][2] ) + l3d_fixedMul( m->m[3][2], m_out->m[2][2] ) );
-    m_out->m[3][3] = l3d_floatToFixed( 1.0f );
 #else
-    m_out->m[0][0] = m->m[0][0]; m_out->m[0][1] = m->m[1][0]; m_out->m[0][2] = m->m[2][0]; m_out->m[0][3] = 0.0f;
-	m_out->m[1][0] = m->m[0][1]; m_out->m[1][1] = m->m[1][1]; m_out->m[1][2] = m->m[2][1]; m_out->m[1][3] = 0.0f;
-	m_out->m[2][0] = m->m[0][2]; m_out->m[2][1] = m->m[1][2]; m_out->m[2][2] = m->m[2][2]; m_out->m[2][3] = 0.0f;
+    m_out->m[0][0] = m->m[0][0]; m_out->m[0][1] = m->m[1][0]; m_out->m[0][2] = m->m[2][0];
+	m_out->m[1][0] = m->m[0][1]; m_out->m[1][1] = m->m[1][1]; m_out->m[1][2] = m->m[2][1];
+	m_out->m[2][0] = m->m[0][2]; m_out->m[2][1] = m->m[1][2]; m_out->m[2][2] = m->m[2][2];
 	m_out->m[3][0] = -(m->m[3][0] * m_out->m[0][0] + m->m[3][1] * m_out->m[1][0] + m->m[3][2] * m_out->m[2][0]);
 	m_out->m[3][1] = -(m->m[3][0] * m_out->m[0][1] + m->m[3][1] * m_out->m[1][1] + m->m[3][2] * m_out->m[2][1]);
 	m_out->m[3][2] = -(m->m[3][0] * m_out->m[0][2] + m->m[3][1] * m_out->m[1][2] + m->m[3][2] * m_out->m[2][2]);
-	m_out->m[3][3] = 1.0f;
 #endif
 }
 #endif	// L3D_CAMERA_MOVABLE
 
-/* 
-// The following will not compile 
-// Screen clipping may be thought about in the future,
-// but it is not the priority
+// 
+// Clipping
+// 
 
-#ifdef L3D_USE_SCREEN_CLIPPING
-// Utility
+// 
+// Signed distance of a point given in homogeneous coordinates to plane p,
+// scaled by the length of the plane's normal.
+// Unlike l3d_plane_distanceToPoint(), the h component is taken into account,
+// so it works in clip space, before the perspective divide.
+// 
+static l3d_rtnl_t homogeneousPlaneDistance( const l3d_plane_t *p, const l3d_vec4_t *v ){
+#ifdef L3D_USE_FIXED_POINT_ARITHMETIC
+    return l3d_fixedMul( p->a, v->x ) + l3d_fixedMul( p->b, v->y ) + l3d_fixedMul( p->c, v->z ) + l3d_fixedMul( p->d, v->h );
+#else
+    return p->a * v->x + p->b * v->y + p->c * v->z + p->d * v->h;
+#endif
+}
 
 // 
-// plane_p - point defining the plane
-// plane_n - normal defining the plane
+// plane - plane given in homogeneous coordinates
 // line_start - first point defining the line
 // line_end - second point defining the line
 // 
-// Returns a point where line intersects with plane given by point and normal
+// Returns a point where line intersects with the plane.
+// All four components are interpolated, so the points
+// may be given in clip space.
 // 
-l3d_vec4_t l3d_intersect_plane(const l3d_vec4_t *plane_p, l3d_vec4_t *plane_n, const l3d_vec4_t *line_start, const l3d_vec4_t *line_end) {
-    *plane_n = l3d_vec4_normalise(plane_n);
-    l3d_rtnl_t plane_d = -l3d_vec4_dotProduct(plane_n, plane_p);
-    l3d_rtnl_t ad = l3d_vec4_dotProduct(line_start, plane_n);
-    l3d_rtnl_t bd = l3d_vec4_dotProduct(line_end, plane_n);
+l3d_vec4_t l3d_intersect_plane(const l3d_plane_t *plane, const l3d_vec4_t *line_start, const l3d_vec4_t *line_end) {
+    l3d_rtnl_t ad = homogeneousPlaneDistance(plane, line_start);
+    l3d_rtnl_t bd = homogeneousPlaneDistance(plane, line_end);
+    if (ad == bd)
+        return *line_start; // parallel to the plane
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
-    l3d_rtnl_t t = l3d_fixedDiv( (-plane_d - ad), (bd- ad) );
+    l3d_rtnl_t t = l3d_fixedDiv( ad, (ad - bd) );
+    return (l3d_vec4_t){
+        line_start->x + l3d_fixedMul( line_end->x - line_start->x, t ),
+        line_start->y + l3d_fixedMul( line_end->y - line_start->y, t ),
+        line_start->z + l3d_fixedMul( line_end->z - line_start->z, t ),
+        line_start->h + l3d_fixedMul( line_end->h - line_start->h, t )
+    };
 #else
-    l3d_rtnl_t t = (-plane_d - ad) / (bd- ad);
+    l3d_rtnl_t t = ad / (ad - bd);
+    return (l3d_vec4_t){
+        line_start->x + (line_end->x - line_start->x) * t,
+        line_start->y + (line_end->y - line_start->y) * t,
+        line_start->z + (line_end->z - line_start->z) * t,
+        line_start->h + (line_end->h - line_start->h) * t
+    };
 #endif  // L3D_USE_FIXED_POINT_ARITHMETIC
-    l3d_vec4_t line_start_to_end = l3d_vec4_sub(line_end, line_start);
-    l3d_vec4_t line_to_intersect = l3d_vec4_mul(&line_start_to_end, t);
-    return l3d_vec4_add(line_start, &line_to_intersect);
 }
 
 // 
-// Returns signed shortest distance from point p to plane defined by its normal plane_n and a point plane_p.
-// Plane normal must be normalised
+// Perspective divide and viewport scale
+// of a single vertex given in clip space.
+// Vertices behind the near plane can not be projected;
+// they are left in clip space, so that edges using them
+// can be clipped later on, and false is returned.
+// A projected vertex keeps its depth in z (0 at the near plane)
+// and the positive clip space w in h.
 // 
-l3d_rtnl_t l3d_point_to_plane_distance(const l3d_vec4_t *p, const l3d_vec4_t *plane_p, const l3d_vec4_t *plane_n ) {
-    l3d_vec4_t n = l3d_vec4_normalise(p);
+bool l3d_clipSpaceToScreenSpace( l3d_vec4_t *v ){
+    if( v->z < l3d_floatToRational(0.0f) || v->h == l3d_floatToRational(0.0f) )
+        return false;
+
+    // Clip space w is negative in front of the camera
+    l3d_rtnl_t w = -v->h;
+
+    // Scale into view, we moved the normalising into cartesian space
+    // out of the matrix.vector function from the previous versions, so
+    // do this manually:
+#if defined(L3D_USE_FIXED_POINT_ARITHMETIC) && defined(L3D_USE_RECIPROCAL_DIVIDE)
+    *v = vec4_divByReciprocal( v, v->h );
+#else
+    *v = l3d_vec4_div( v, v->h );
+#endif
+    v->z = -v->z;
+
+    l3d_vec4_t v_offset_view = l3d_getVec4FromFloat( 1.0f, 1.0f, 0.0f, 0.0f );
+
+    *v = l3d_vec4_add( v, &v_offset_view );
+
 #ifdef L3D_USE_FIXED_POINT_ARITHMETIC
-    return (l3d_fixedMul(plane_n->x, p->x) + l3d_fixedMul(plane_n->y, p->y) + l3d_fixedMul(plane_n->z, p->z) - l3d_vec4_dotProduct(plane_n, plane_p));
+    v->x = l3d_fixedMul( v->x, l3d_floatToFixed(0.5f * (l3d_flp_t)SCREEN_WIDTH) );
+    v->y = l3d_fixedMul( v->y, l3d_floatToFixed(0.5f * (l3d_flp_t)SCREEN_HEIGHT) );
 #else
-    return (plane_n->x * p->x + plane_n->y * p->y + plane_n->z * p->z - l3d_vec4_dotProduct(plane_n, plane_p));
-#endif  // L3D_USE_FIXED_POINT_ARITHMETIC
+    v->x *= 0.5f * (l3d_flp_t)SCREEN_WIDTH;
+    v->y *= 0.5f * (l3d_flp_t)SCREEN_HEIGHT;
+#endif
+    v->h = w;
+    return true;
+}
+
+// 
+// Clip line segment against plane in homogeneous coordinates.
+// The part lying behind the plane (negative distance) is cut off
+// and the endpoint is moved onto the plane.
+// Returns false if the whole segment lies behind the plane.
+// 
+bool l3d_clipLineAgainstPlane(const l3d_plane_t *plane, l3d_vec4_t *line_start, l3d_vec4_t *line_end) {
+    bool start_inside = homogeneousPlaneDistance(plane, line_start) >= l3d_floatToRational(0.0f);
+    bool end_inside = homogeneousPlaneDistance(plane, line_end) >= l3d_floatToRational(0.0f);
+
+    if (!start_inside && !end_inside)
+        return false;
+    
+    if (!start_inside)
+        *line_start = l3d_intersect_plane(plane, line_end, line_start);
+    else if (!end_inside)
+        *line_end = l3d_intersect_plane(plane, line_start, line_end);
+
+    return true;
+}
+
+// Cohen-Sutherland outcodes
+#define L3D_OUTCODE_INSIDE  0
+#define L3D_OUTCODE_LEFT    (1<<0)
+#define L3D_OUTCODE_RIGHT   (1<<1)
+#define L3D_OUTCODE_TOP     (1<<2)
+#define L3D_OUTCODE_BOTTOM  (1<<3)
+
+static uint8_t computeOutCode( int32_t x, int32_t y, const l3d_rect_t *r ){
+    uint8_t code = L3D_OUTCODE_INSIDE;
+    if( x < r->x_min )
+        code |= L3D_OUTCODE_LEFT;
+    else if( x > r->x_max )
+        code |= L3D_OUTCODE_RIGHT;
+    if( y < r->y_min )
+        code |= L3D_OUTCODE_TOP;
+    else if( y > r->y_max )
+        code |= L3D_OUTCODE_BOTTOM;
+    return code;
+}
+
+// 
+// Clip line segment given in integer screen coordinates
+// against rectangle r (bounds inclusive) using the Cohen-Sutherland algorithm.
+// Endpoints lying outside are moved onto the rectangle's border.
+// Returns false if the whole segment lies outside the rectangle.
+// 
+bool l3d_clipLineToRect( int32_t *x0, int32_t *y0, int32_t *x1, int32_t *y1, const l3d_rect_t *r ){
+    uint8_t code0 = computeOutCode( *x0, *y0, r );
+    uint8_t code1 = computeOutCode( *x1, *y1, r );
+
+    while( true ){
+        // Both endpoints inside - trivially accept
+        if( !(code0 | code1) )
+            return true;
+        // Both endpoints share an outside zone - trivially reject
+        if( code0 & code1 )
+            return false;
+
+        // Move the endpoint lying outside onto the border it crosses.
+        // 64-bit products, as off-screen coordinates may be large.
+        uint8_t code_out = code0 ? code0 : code1;
+        int64_t dx = (int64_t)*x1 - *x0;
+        int64_t dy = (int64_t)*y1 - *y0;
+        int32_t x, y;
+
+        if( code_out & L3D_OUTCODE_BOTTOM ){
+            x = *x0 + (int32_t)( dx * ( r->y_max - *y0 ) / dy );
+            y = r->y_max;
+        }
+        else if( code_out & L3D_OUTCODE_TOP ){
+            x = *x0 + (int32_t)( dx * ( r->y_min - *y0 ) / dy );
+            y = r->y_min;
+        }
+        else if( code_out & L3D_OUTCODE_RIGHT ){
+            y = *y0 + (int32_t)( dy * ( r->x_max - *x0 ) / dx );
+            x = r->x_max;
+        }
+        else {
+            y = *y0 + (int32_t)( dy * ( r->x_min - *x0 ) / dx );
+            x = r->x_min;
+        }
+
+        if( code_out == code0 ){
+            *x0 = x;
+            *y0 = y;
+            code0 = computeOutCode( *x0, *y0, r );
+        }
+        else {
+            *x1 = x;
+            *y1 = y;
+            code1 = computeOutCode( *x1, *y1, r );
+        }
+    }
 }
 
+/* 
+// The following will not compile 
+// Triangle clipping may be thought about in the future,
+// but it is not the priority;
+// for wireframes see l3d_clipLineAgainstPlane()
+
+#ifdef L3D_USE_SCREEN_CLIPPING
+// Utility
+
 // 
 // Clip triangle in world space
 // Returns how many triangles are returned by this function
@@ -3,7 +3,6 @@
 // Used only by l3d_scene_getObjectLocalUnitVec...()
 // May change in the future
 typedef enum l3d_dummy_axis_enum {
-    L3D_AXIS_LOCAL_POS, // duplicate of local_pos; remove this or local_pos
     L3D_AXIS_X,
     L3D_AXIS_Y,
     L3D_AXIS_Z
@@ -31,12 +30,16 @@ l3d_err_t l3d_scene_setActiveCamera(l3d_scene_t *scene, uint16_t cam_idx){
 		return L3D_WRONG_PARAM;
 	
 	scene->active_camera_idx = cam_idx;
+
+	// View and projection matrices have to be recomputed
+	// and every object has to be projected again
+	scene->cameras[cam_idx].has_moved = true;
+	scene->cameras[cam_idx].is_modified = true;
 	return L3D_OK;
 }
 
 l3d_vec4_t l3d_scene_getObjectLocalPos(const l3d_scene_t *scene, l3d_obj_type_t type, uint16_t idx) {
 	if (scene != NULL) {
-		l3d_obj3d_t *obj = NULL;
 		l3d_camera_t *cam = NULL;
 		switch (type) {
 			case L3D_OBJ_TYPE_CAMERA:
@@ -45,10 +48,9 @@ l3d_vec4_t l3d_scene_getObjectLocalPos(const l3d_scene_t *scene, l3d_obj_type_t
 					break;
 				return cam->local_pos;
 			case L3D_OBJ_TYPE_OBJ3D:
-				obj = &scene->objects[idx];
-				if (obj == NULL)
+				if (idx >= scene->object_count)
 					break;
-				return obj->local_pos;
+				return L3D_OBJ_LOCAL_POS(scene, idx);
 		}
 	}
 	return l3d_getZeroVec4();
@@ -58,20 +60,20 @@ l3d_err_t l3d_scene_setObjectLocalPos(l3d_scene_t *scene, l3d_obj_type_t type, u
 	if (scene == NULL || pos == NULL)
 		return L3D_WRONG_PARAM;
 	
-	l3d_obj3d_t *obj = NULL;
 	l3d_camera_t *cam = NULL;
 	switch (type) {
 		case L3D_OBJ_TYPE_CAMERA:
+			if (idx >= scene->camera_count)
+				return L3D_WRONG_PARAM;
 			cam = &scene->cameras[idx];
-			if (cam == NULL)
-				return L3D_DATA_EMPTY;
 			cam->local_pos = *pos;
+			cam->has_moved = true;
 			break;
 		case L3D_OBJ_TYPE_OBJ3D:
-			obj = &scene->objects[idx];
-			if (obj == NULL)
-				return L3D_DATA_EMPTY;
-			obj->local_pos = *pos;
+			if (idx >= scene->object_count)
+				return L3D_WRONG_PARAM;
+			L3D_OBJ_LOCAL_POS(scene, idx) = *pos;
+			L3D_OBJ_UPDATED(scene, idx) = true;
 			break;
 		default:
 			return L3D_WRONG_PARAM;
@@ -81,7 +83,6 @@ l3d_err_t l3d_scene_setObjectLocalPos(l3d_scene_t *scene, l3d_obj_type_t type, u
 
 l3d_quat_t l3d_scene_getObjectOrientation(const l3d_scene_t *scene, l3d_obj_type_t type, uint16_t idx) {
 	if (scene != NULL) {
-		l3d_obj3d_t *obj = NULL;
 		l3d_camera_t *cam = NULL;
 		switch (type) {
 			case L3D_OBJ_TYPE_CAMERA:
@@ -90,10 +91,9 @@ l3d_quat_t l3d_scene_getObjectOrientation(const l3d_scene_t *scene, l3d_obj_type
 					break;
 				return cam->orientation;
 			case L3D_OBJ_TYPE_OBJ3D:
-				obj = &scene->objects[idx];
-				if (obj == NULL)
+				if (idx >= scene->object_count)
 					break;
-				return obj->orientation;
+				return L3D_OBJ_ORIENTATION(scene, idx);
 			default:
 				break;
 		}
@@ -105,20 +105,20 @@ l3d_err_t l3d_scene_setObjectOrientation(l3d_scene_t *scene, l3d_obj_type_t type
 	if (scene == NULL || q == NULL)
 		return L3D_WRONG_PARAM;
 	
-	l3d_obj3d_t *obj = NULL;
 	l3d_camera_t *cam = NULL;
 	switch (type) {
 		case L3D_OBJ_TYPE_CAMERA:
+			if (idx >= scene->camera_count)
+				return L3D_WRONG_PARAM;
 			cam = &scene->cameras[idx];
-			if (cam == NULL)
-				return L3D_DATA_EMPTY;
 			cam->orientation = *q;
+			cam->has_moved = true;
 			break;
 		case L3D_OBJ_TYPE_OBJ3D:
-			obj = &scene->objects[idx];
-			if (obj == NULL)
-				return L3D_DATA_EMPTY;
-			obj->orientation = *q;
+			if (idx >= scene->object_count)
+				return L3D_WRONG_PARAM;
+			L3D_OBJ_ORIENTATION(scene, idx) = *q;
+			L3D_OBJ_UPDATED(scene, idx) = true;
 			break;
 		default:
 			return L3D_WRONG_PARAM;
@@ -126,24 +126,47 @@ l3d_err_t l3d_scene_setObjectOrientation(l3d_scene_t *scene, l3d_obj_type_t type
 	return L3D_OK;
 }
 
+bool l3d_scene_isObjectVisible(const l3d_scene_t *scene, uint16_t idx) {
+	if (scene == NULL || idx >= scene->object_count)
+		return false;
+	return L3D_OBJ_VISIBLE(scene, idx);
+}
+
+// 
+// Show or hide a 3D object.
+// Hidden objects are neither projected nor drawn by l3d_processScene().
+// 
+l3d_err_t l3d_scene_setObjectVisible(l3d_scene_t *scene, uint16_t idx, bool visible) {
+	if (scene == NULL || idx >= scene->object_count)
+		return L3D_WRONG_PARAM;
+	L3D_OBJ_VISIBLE(scene, idx) = visible;
+	return L3D_OK;
+}
+
+// 
+// Get unit vector of object's local axis expressed in global coordinates.
+// Derived from object's orientation, so it is valid
+// even before the object gets transformed into world space.
+// 
 l3d_vec4_t l3d_scene_getObjectLocalUnitVecIdx(const l3d_scene_t *scene, l3d_obj_type_t type, uint16_t idx, l3d_axis_t axis_idx) {
-	if (scene != NULL) {
-		l3d_camera_t *cam = NULL;
-		l3d_obj3d_t *obj = NULL;
-		switch (type) {
-			case L3D_OBJ_TYPE_CAMERA:
-				cam = &scene->cameras[idx];
-				if (cam == NULL)
-					break;
-				return l3d_vec4_sub(&cam->u_world[axis_idx], &cam->u_world[L3D_AXIS_LOCAL_POS]);	// replace u_world[] with local_pos
-			case L3D_OBJ_TYPE_OBJ3D:
-				obj = &scene->objects[idx];
-				if (obj == NULL)
-					break;
-				return l3d_vec4_sub(&obj->u_world[axis_idx], &obj->u_world[L3D_AXIS_LOCAL_POS]);	// replace u_world[] with local_pos
-		}
+	l3d_vec4_t axis;
+	switch (axis_idx) {
+		case L3D_AXIS_X:
+			axis = l3d_getVec4FromFloat(1.0f, 0.0f, 0.0f, 1.0f);
+			break;
+		case L3D_AXIS_Y:
+			axis = l3d_getVec4FromFloat(0.0f, 1.0f, 0.0f, 1.0f);
+			break;
+		case L3D_AXIS_Z:
+			axis = l3d_getVec4FromFloat(0.0f, 0.0f, 1.0f, 1.0f);
+			break;
+		default:
+			return l3d_getZeroVec4();
 	}
-	return l3d_getZeroVec4();
+
+	l3d_quat_t q = l3d_scene_getObjectOrientation(scene, type, idx);
+	q = l3d_quat_normalise(&q);
+	return l3d_rotateVecByQuat(&axis, &q);
 }
 
 l3d_vec4_t l3d_scene_getObjectLocalUnitVecX(const l3d_scene_t *scene, l3d_obj_type_t type, uint16_t idx) {
@@ -157,3 +180,17 @@ l3d_vec4_t l3d_scene_getObjectLocalUnitVecY(const l3d_scene_t *scene, l3d_obj_ty
 l3d_vec4_t l3d_scene_getObjectLocalUnitVecZ(const l3d_scene_t *scene, l3d_obj_type_t type, uint16_t idx) {
 	return l3d_scene_getObjectLocalUnitVecIdx(scene, type, idx, L3D_AXIS_Z);
 }
+
+#ifdef L3D_USE_DIRTY_RECTANGLES
+// 
+// Get screen regions changed by the last l3d_processScene() call.
+// Only these have to be cleared and sent to the display again.
+// The rectangles do not overlap; their number is put into count.
+// 
+const l3d_rect_t *l3d_scene_getDirtyRects(const l3d_scene_t *scene, uint8_t *count) {
+	if (scene == NULL || count == NULL)
+		return NULL;
+	*count = scene->dirty_rect_count;
+	return scene->dirty_rects;
+}
+#endif	// L3D_USE_DIRTY_RECTANGLES
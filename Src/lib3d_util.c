@@ -8,6 +8,23 @@ void __attribute__((weak)) l3d_drawLineCallback( int32_t x0, int32_t y0, int32_t
   	*/
 }
 
+void __attribute__((weak)) l3d_drawSpanCallback( int32_t y, int32_t x0, int32_t x1, l3d_colour_t colour ){
+	/* NOTE: This function Should not be modified, when the callback is needed,
+       l3d_drawSpanCallback could be implemented in a user file
+  	*/
+
+	l3d_drawLineCallback( x0, y, x1, y, colour );
+}
+
+void __attribute__((weak)) l3d_drawLinesCallback( const l3d_line_t *lines, uint16_t count ){
+	/* NOTE: This function Should not be modified, when the callback is needed,
+       l3d_drawLinesCallback could be implemented in a user file
+  	*/
+
+	for( uint16_t i=0; i<count; i++ )
+		l3d_drawLineCallback( lines[i].x0, lines[i].y0, lines[i].x1, lines[i].y1, lines[i].colour );
+}
+
 void __attribute__((weak)) l3d_putTextCallback( int32_t x, int32_t y, char* str, l3d_colour_t colour ){
 	/* NOTE: This function Should not be modified, when the callback is needed,
        l3d_putTextCallback could be implemented in a user file
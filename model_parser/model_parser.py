@@ -8,27 +8,42 @@ import os
 import configparser
 import numpy as np
 from icecream import ic
-from math import sqrt
+from math import sqrt, ceil, log2, floor
 import argparse
 import pathlib
 from collections import Counter # to check for duplicates
 
+# Header with L3D_FP_DP, included by lib3d_config.h with L3D_USE_GENERATED_FP_FORMAT
+FP_FORMAT_HEADER = 'lib3d_fp_format.h'
+# Range of L3D_FP_DP accepted by lib3d_math.h
+FP_MIN_DP = 10
+FP_MAX_DP = 24
+# Room for the sums of products in matrix multiplications and dot products
+FP_HEADROOM = 4
+# How far off the screen projected vertices may land, in screen sizes
+FP_SCREEN_MARGIN = 4
+# L3D_CAMERA_DEFAULT_FAR_PLANE, set by l3d_cam_reset()
+CAMERA_DEFAULT_FAR_PLANE = 1000.0
+
 class Edge:
 	"""
 	Mesh edge class, for more readable computations.
 	v1_id, v2_id - ID's of points in space (of Vec4 type)
 	face_id (tri_id) - ID of first face the edge was mentioned in (belongs to)
+	face2_id - ID of the other face the edge belongs to
+		(EdgeNoFaceID from config, L3D_EDGE_NO_FACE, if there is none)
 	"""
 	def __init__(self, v1_id, v2_id, face_id, is_visible, is_boundary, is_silhouette):
 		self.v1_id = v1_id
 		self.v2_id = v2_id
 		self.face_id = face_id
+		self.face2_id = -1
 		self.is_visible = is_visible
 		self.is_boundary = is_boundary
 		self.is_silhouette = is_silhouette
 	
 	def __str__(self):
-		s = f"{self.v1_id}-{self.v2_id},\tface ID: {self.face_id},\t"
+		s = f"{self.v1_id}-{self.v2_id},\tface ID's: {self.face_id}, {self.face2_id},\t"
 
 		if self.is_visible:
 			s += "visible"
@@ -100,7 +115,7 @@ class Mesh:
 	"""
 	Stores the information about given mesh.
 	"""
-	def __init__(self, name, instance_count, vertex_array, face_array, edge_array, edge_flags_array):
+	def __init__(self, name, instance_count, vertex_array, face_array, edge_array, edge_flags_array, face_normal_array, bounding_sphere, vert_quant=None):
 		self.name = name
 		self.instance_count = instance_count
 
@@ -108,6 +123,9 @@ class Mesh:
 		self.face_array = face_array
 		self.edge_array = edge_array
 		self.edge_flags_array = edge_flags_array
+		self.face_normal_array = face_normal_array
+		self.bounding_sphere = bounding_sphere
+		self.vert_quant = vert_quant	# [offset x, offset y, offset z, shift] of quantised vertices
 
 		self.vertex_count = len(vertex_array)
 		self.face_count = len(face_array)
@@ -413,9 +431,14 @@ def get_edge_array(config, mesh_name, vert_array, face_array) -> tuple:
 			entry_id += 1
 		
 		if face2_id == -1:
-			print(f"Error: in get_edge_array(): could not find the other face the edge ({str(edge)}) belongs to. Returning.")
-			return ('','')
+			# Edge of an open mesh - it belongs to a single face only.
+			# Mark the missing face with L3D_EDGE_NO_FACE
+			# and treat the edge as boundary of the mesh
+			edge.face2_id = config['EdgeNoFaceID']
+			edge.is_boundary = True
+			continue
 		
+		edge.face2_id = face2_id
 		# face2 = face_array[face2_id]
 		face2_normal = face_normals[face2_id]
 
@@ -467,7 +490,7 @@ def get_edge_array(config, mesh_name, vert_array, face_array) -> tuple:
 		# flags |= edge.is_silhouette << 0
 		edge_flags.append(flags)
 		edge_flags_str += f'\t{flags}'
-		s += f'\t{edge.v1_id}, {edge.v2_id}, {edge.face_id}'
+		s += f'\t{edge.v1_id}, {edge.v2_id}, {edge.face_id}, {edge.face2_id}'
 			# s += f'\t{edge.v1_id}, {edge.v2_id}, {edge.face_id}, {flags}'
 		# else:
 			# s += f'\t{edge.v1_id}, {edge.v2_id}, {edge.face_id}, {edge.is_visible}, {edge.is_boundary}, {edge.is_silhouette}'
@@ -482,7 +505,131 @@ def get_edge_array(config, mesh_name, vert_array, face_array) -> tuple:
 	s += "};\n"
 	edge_flags_str += "};\n"
 
-	return (s, edge_flags_str, edge_list, edge_flags)
+	return (s, edge_flags_str, edge_list, edge_flags, face_normals)
+
+def get_bounding_sphere(config, vert_array) -> list:
+	"""
+	Compute mesh's bounding sphere used for frustum culling.
+	Returns [centre x, centre y, centre z, radius]
+	in the same representation as the vertex data.
+	The centre is the middle of the axis-aligned bounding box,
+	which is not the smallest sphere, but is good enough and cheap.
+	"""
+	vertices = [Vec4(v[0], v[1], v[2], 1) for v in vert_array]
+
+	v_min = Vec4(min(v.x for v in vertices), min(v.y for v in vertices), min(v.z for v in vertices), 1)
+	v_max = Vec4(max(v.x for v in vertices), max(v.y for v in vertices), max(v.z for v in vertices), 1)
+	centre = Vec4((v_min.x + v_max.x) / 2, (v_min.y + v_max.y) / 2, (v_min.z + v_max.z) / 2, 1)
+
+	radius = max(v.sub(centre).length() for v in vertices)
+
+	if config.getboolean('UseFixedPoint'):
+		# Vertex data is already scaled, so only round the values.
+		# Round the radius up, so that the sphere still contains every vertex
+		return [round(centre.x), round(centre.y), round(centre.z), ceil(radius)]
+	
+	return [f'{centre.x:f}', f'{centre.y:f}', f'{centre.z:f}', f'{radius:f}']
+
+def get_quantised_vertex_array(config, vert_array) -> tuple:
+	"""
+	Quantise fixed point vertices of a mesh to int16_t,
+	so that vertex = offset + q * 2^shift (see l3d_vert_quant_t).
+	The offset is the middle of the axis-aligned bounding box and shift
+	the smallest one that fits the mesh; 0 keeps the vertices exact.
+	Returns (quantised vertex array, [offset x, offset y, offset z, shift]).
+	"""
+	offset = [(min(int(v[i]) for v in vert_array) + max(int(v[i]) for v in vert_array)) // 2 for i in range(3)]
+	max_dist = max(abs(int(v[i]) - offset[i]) for v in vert_array for i in range(3))
+
+	shift = 0
+	while (max_dist + ((1 << shift) >> 1)) >> shift > 32767:
+		shift += 1
+	if shift > 14:
+		print("Error: mesh too large to be quantised (half-extent of 8192 or more). Aborting")
+		sys.exit(1)
+
+	quantised = [[(int(v[i]) - offset[i] + ((1 << shift) >> 1)) >> shift for i in range(3)] for v in vert_array]
+	return (quantised, offset + [shift])
+
+def get_fixed_point_format(models_lines, scene_radius, far_plane, screen_size) -> tuple:
+	"""
+	Choose the number of fractional bits of the fixed point format (L3D_FP_DP)
+	from the range of values the scene goes through at run time:
+	world positions of vertices of objects placed up to scene_radius away
+	from the origin, view space positions seen by cameras within the same radius,
+	depth up to the far plane and vertices projected off the screen.
+	All but the last one get FP_HEADROOM times their magnitude,
+	the bits left over after the integer part are fractional.
+	Returns (fractional bits, lines describing the analysis).
+	"""
+	coords = [float(x) for vert_lines, _ in models_lines for line in vert_lines for x in line.split()[1:4]]
+	mesh_radius = max(sqrt(sum(float(x)**2 for x in line.split()[1:4])) for vert_lines, _ in models_lines for line in vert_lines)
+
+	# The shortest edge tells how many steps of the format the smallest details get
+	min_edge = None
+	for vert_lines, face_lines in models_lines:
+		verts = [[float(x) for x in line.split()[1:4]] for line in vert_lines]
+		for line in face_lines:
+			ids = [int(x) - 1 for x in line.split()[1:]]
+			for a, b in zip(ids, ids[1:] + ids[:1]):
+				length = sqrt(sum((verts[a][i] - verts[b][i])**2 for i in range(3)))
+				if length > 0 and (min_edge is None or length < min_edge):
+					min_edge = length
+
+	model_range = max(abs(x) for x in coords)
+	world_range = scene_radius + mesh_radius
+	# Camera and object on opposite sides of the scene
+	view_range = 2 * world_range
+	screen_range = FP_SCREEN_MARGIN * max(screen_size)
+	needed = max(FP_HEADROOM * max(model_range, view_range, far_plane), screen_range)
+
+	# Largest value of the format, 2^(31 - dp), has to exceed the needed range
+	fp_dp = min(30 - floor(log2(needed)), FP_MAX_DP)
+	if fp_dp < FP_MIN_DP:
+		print(f"Error: scene range of {needed:g} does not fit fixed point numbers with {FP_MIN_DP} or more fractional bits, use floating point. Aborting")
+		sys.exit(1)
+
+	analysis = [
+		f"Largest model coordinate: {model_range:g}, model radius: {mesh_radius:g}",
+		f"Scene radius (object and camera positions): {scene_radius:g}, world range: {world_range:g}",
+		f"View space range: {view_range:g}, far plane: {far_plane:g}",
+		f"Screen: {screen_size[0]}x{screen_size[1]}, projected vertices up to {screen_range:g}",
+		f"Needed range with x{FP_HEADROOM} headroom: {needed:g}",
+	]
+	if min_edge is not None:
+		analysis.append(f"Shortest edge: {min_edge:g}, {min_edge * (1 << fp_dp):.0f} steps of the format")
+	return (fp_dp, analysis)
+
+def get_fp_format_header_content(config, scene_name, fp_dp, analysis) -> str:
+	"""
+	Returns string with the content of the header setting L3D_FP_DP
+	"""
+	s =	 "// \n"
+	s += f"// {config['InfoGeneratedBy']}\n"
+	s += f"// Fixed point format of scene {scene_name}, used with L3D_USE_GENERATED_FP_FORMAT\n"
+	s += "// \n"
+	for line in analysis:
+		s += f"// {line}\n"
+	s += f"// Format: Q{32 - fp_dp}.{fp_dp}, values below {1 << (31 - fp_dp)}, resolution {1.0 / (1 << fp_dp):g}\n"
+	s += "// \n"
+	s += "\n"
+	s += "#ifndef _L3D_FP_FORMAT_H_\n"
+	s += "#define _L3D_FP_FORMAT_H_\n"
+	s += "\n"
+	s += f"#define L3D_FP_DP {fp_dp}\n"
+	s += "\n"
+	s += "#endif // _L3D_FP_FORMAT_H_\n"
+	return s
+
+def get_rational_str(config, value) -> str:
+	"""
+	Convert floating point value to a string of the rational type used by the library
+	"""
+	if config.getboolean('UseFixedPoint'):
+		fp_dp = config.getint('FixedPointBinaryDigits')
+		return str(round(value * float(1<<fp_dp)))
+	
+	return f'{value:f}'
 
 def get_header_comment(config, scene) -> str:
 	"""
@@ -535,6 +682,14 @@ def get_defines(scene):
 	s += f"#define {scene_name}_FACE_FLAG_COUNT {scene.face_flag_count}\n"
 	s += f"#define {scene_name}_EDGE_FLAG_COUNT {scene.edge_flag_count}\n"
 
+	s += "\n"
+	s += "// Indices, counts and offsets of the scene have to fit in l3d_index_t\n"
+	s += f"#if !defined(L3D_USE_32BIT_INDICES) && ({scene_name}_MODEL_VERT_COUNT * 3 > 65535 || {scene_name}_MODEL_FACE_COUNT * 3 > 65535 || \\\n"
+	s += f"\t{scene_name}_MODEL_EDGE_COUNT * L3D_EDGE_DATA_STRIDE > 65535 || {scene_name}_TRANSFORMED_VERT_COUNT > 65535 || \\\n"
+	s += f"\t{scene_name}_FACE_FLAG_COUNT > 65535 || {scene_name}_EDGE_FLAG_COUNT > 65535)\n"
+	s += "#error \"Scene too large for 16 bit indices, define L3D_USE_32BIT_INDICES in lib3d_config.h\"\n"
+	s += "#endif\n"
+
 	s += "\n"
 	s += "// \n"
 	s += "// Object defines\n"
@@ -553,10 +708,30 @@ def get_declarations(config, scene):
 	# TODO: replace string literals e.g. "_vertices_world" with some defined names
 	s = ''
 	s += f"{config['SceneStructType']} {scene.name};\n"
+	s += "#ifdef L3D_USE_SOA_VERTICES\n"
+	for coord in ['x', 'y', 'z']:
+		s += f"{config['RationalType']} {scene.name}_vertices_world_{coord}[{scene.name.upper()}_TRANSFORMED_VERT_COUNT];\n"
+	for coord in ['x', 'y']:
+		s += f"{config['ScreenCoordArrayType']} {scene.name}_vertices_screen_{coord}[{scene.name.upper()}_TRANSFORMED_VERT_COUNT];\n"
+	s += "#else\n"
 	s += f"{config['Vec4StructType']} {scene.name}_vertices_world[{scene.name.upper()}_TRANSFORMED_VERT_COUNT];\n"
 	s += f"{config['Vec4StructType']} {scene.name}_vertices_projected[{scene.name.upper()}_TRANSFORMED_VERT_COUNT];\n"
+	s += "#endif\n"
 	s += f"{config['FaceFlagsArrayType']} {scene.name}_face_flags[{scene.name.upper()}_FACE_FLAG_COUNT];\n"
+	s += "#ifdef L3D_USE_SOA_OBJECTS\n"
+	for type_key, component in [('MeshStructType', 'meshes'),
+								('Vec4StructType', 'positions'),
+								('QuatStructType', 'orientations'),
+								('ObjectFlagsStructType', 'flags'),
+								('ObjectGizmoStructType', 'gizmos'),
+								('ObjectColoursStructType', 'colours')]:
+		s += f"{config[type_key]} {scene.name}_object_{component}[{scene.name.upper()}_OBJ_COUNT];\n"
+	s += "#if defined(L3D_USE_DIRTY_RECTANGLES) || defined(REMOVE_HIDDEN_LINES_ANALYTIC)\n"
+	s += f"{config['RectStructType']} {scene.name}_object_screen_rects[{scene.name.upper()}_OBJ_COUNT];\n"
+	s += "#endif\n"
+	s += "#else\n"
 	s += f"{config['ObjectStructType']} {scene.name}_objects[{scene.name.upper()}_OBJ_COUNT];\n"
+	s += "#endif\n"
 	s += f"{config['SceneInstanceDescriptorStructType']} {scene.name}_mesh_instances[{scene.name.upper()}_MESH_COUNT];\n"
 	s += f"{config['CameraStructType']} {scene.name}_cameras[{scene.name.upper()}_CAM_COUNT];\n"
 
@@ -567,6 +742,9 @@ def get_init_objects(config, scene) -> str:
 	Returns a string containing init_objects() function
 	"""
 	s = f"static {config['ErrorType']} init_objects(void) " + "{\n"
+	# Objects are initialised through L3D_OBJ_...() accessors,
+	# so the same code works with both object layouts
+	scene_ptr = f"&{scene.name}"
 
 	# vertex_data_offset = 0
 	# face_data_offset = 0
@@ -580,9 +758,9 @@ def get_init_objects(config, scene) -> str:
 		s += f"\tfor (uint16_t i = {scene.name}_mesh_instances[{mesh_idx}].first_instance_idx;\n"
 		s += f"\t\ti < {scene.name}_mesh_instances[{mesh_idx}].first_instance_idx + {scene.name.upper()}_OBJ_{mesh.name.upper()}_INSTANCE_COUNT;\n"
 		s += "\t\ti++)" + " {\n"
-		s += f"\t\t{scene.name}_objects[i].mesh.vert_count = MESH_{mesh.name.upper()}_VERT_COUNT;\n"
-		s += f"\t\t{scene.name}_objects[i].mesh.tri_count = MESH_{mesh.name.upper()}_FACE_COUNT;\n"
-		s += f"\t\t{scene.name}_objects[i].mesh.edge_count = MESH_{mesh.name.upper()}_EDGE_COUNT;\n"
+		s += f"\t\tL3D_OBJ_MESH({scene_ptr}, i).vert_count = MESH_{mesh.name.upper()}_VERT_COUNT;\n"
+		s += f"\t\tL3D_OBJ_MESH({scene_ptr}, i).tri_count = MESH_{mesh.name.upper()}_FACE_COUNT;\n"
+		s += f"\t\tL3D_OBJ_MESH({scene_ptr}, i).edge_count = MESH_{mesh.name.upper()}_EDGE_COUNT;\n"
 		s += "\t}\n"
 		s += "\n"
 		mesh_idx += 1
@@ -596,52 +774,57 @@ def get_init_objects(config, scene) -> str:
 	# s += "\n"
 
 	s += """
-	uint16_t model_vert_data_offset = 0;
-	uint16_t model_tri_data_offset = 0;
-	uint16_t model_edge_data_offset = 0;
-	uint16_t transformed_vertices_offset = 0;
-	uint16_t tris_flags_offset = 0;
-	uint16_t edges_flags_offset = 0;\n"""
+	l3d_index_t model_vert_data_offset = 0;
+	l3d_index_t model_tri_data_offset = 0;
+	l3d_index_t model_edge_data_offset = 0;
+	l3d_index_t model_bsphere_data_offset = 0;
+	l3d_index_t transformed_vertices_offset = 0;
+	l3d_index_t tris_flags_offset = 0;
+	l3d_index_t edges_flags_offset = 0;\n"""
 	s += "\n"
 
 	s += f"\tfor (uint16_t i = 0; i < {scene.name.upper()}_MESH_COUNT; i++)"+" {\n"
 	# for mesh in scene.meshes:
 	s += f"\t\tfor (uint16_t instance_idx = 0; instance_idx < {scene.name}_mesh_instances[i].instance_count; instance_idx++)"+" {\n"
 	s += f"\t\t\tuint16_t obj_id = {scene.name}_mesh_instances[i].first_instance_idx + instance_idx;\n"
-	s += f"\t\t\t{scene.name}_objects[obj_id].mesh.model_vert_data_offset = model_vert_data_offset;\n"
-	s += f"\t\t\t{scene.name}_objects[obj_id].mesh.model_tri_data_offset = model_tri_data_offset;\n"
-	s += f"\t\t\t{scene.name}_objects[obj_id].mesh.model_edge_data_offset = model_edge_data_offset;\n"
+	s += f"\t\t\tL3D_OBJ_MESH({scene_ptr}, obj_id).model_vert_data_offset = model_vert_data_offset;\n"
+	s += f"\t\t\tL3D_OBJ_MESH({scene_ptr}, obj_id).model_tri_data_offset = model_tri_data_offset;\n"
+	s += f"\t\t\tL3D_OBJ_MESH({scene_ptr}, obj_id).model_edge_data_offset = model_edge_data_offset;\n"
+	s += f"\t\t\tL3D_OBJ_MESH({scene_ptr}, obj_id).model_bsphere_data_offset = model_bsphere_data_offset;\n"
+	if config.getboolean('QuantiseVertices', fallback=False):
+		s += f"\t\t\tL3D_OBJ_MESH({scene_ptr}, obj_id).model_vert_quant_idx = i;\n"
 	s += "\n"
-	s += f"\t\t\t{scene.name}_objects[obj_id].mesh.transformed_vertices_offset = transformed_vertices_offset;\n"
-	s += f"\t\t\t{scene.name}_objects[obj_id].mesh.tris_flags_offset = tris_flags_offset;	// not used for now\n"
-	s += f"\t\t\t{scene.name}_objects[obj_id].mesh.edges_flags_offset = edges_flags_offset;\n"
+	s += f"\t\t\tL3D_OBJ_MESH({scene_ptr}, obj_id).transformed_vertices_offset = transformed_vertices_offset;\n"
+	s += f"\t\t\tL3D_OBJ_MESH({scene_ptr}, obj_id).tris_flags_offset = tris_flags_offset;\n"
+	s += f"\t\t\tL3D_OBJ_MESH({scene_ptr}, obj_id).edges_flags_offset = edges_flags_offset;\n"
 	s += "\n"
-	s += f"\t\t\ttransformed_vertices_offset += {scene.name}_objects[obj_id].mesh.vert_count;\n"
-	s += f"\t\t\ttris_flags_offset += {scene.name}_objects[obj_id].mesh.tri_count;\n"
-	s += f"\t\t\tedges_flags_offset += {scene.name}_objects[obj_id].mesh.edge_count;\n"
+	s += f"\t\t\ttransformed_vertices_offset += L3D_OBJ_MESH({scene_ptr}, obj_id).vert_count;\n"
+	s += f"\t\t\ttris_flags_offset += L3D_OBJ_MESH({scene_ptr}, obj_id).tri_count;\n"
+	s += f"\t\t\tedges_flags_offset += L3D_OBJ_MESH({scene_ptr}, obj_id).edge_count;\n"
 	s += "\t\t}\n"
 	s += "\n"
 	s += "\t\t// Update offsets\n"
-	s += f"\t\tmodel_vert_data_offset += {scene.name}_objects[{scene.name}_mesh_instances[i].first_instance_idx].mesh.vert_count * 3; // check correctness\n"
-	s += f"\t\tmodel_tri_data_offset += {scene.name}_objects[{scene.name}_mesh_instances[i].first_instance_idx].mesh.tri_count * 3; // check correctness\n"
-	s += f"\t\tmodel_edge_data_offset += {scene.name}_objects[{scene.name}_mesh_instances[i].first_instance_idx].mesh.edge_count * 3; // check correctness\n"
+	s += f"\t\tmodel_vert_data_offset += L3D_OBJ_MESH({scene_ptr}, {scene.name}_mesh_instances[i].first_instance_idx).vert_count * 3; // check correctness\n"
+	s += f"\t\tmodel_tri_data_offset += L3D_OBJ_MESH({scene_ptr}, {scene.name}_mesh_instances[i].first_instance_idx).tri_count * 3; // check correctness\n"
+	s += f"\t\tmodel_edge_data_offset += L3D_OBJ_MESH({scene_ptr}, {scene.name}_mesh_instances[i].first_instance_idx).edge_count * L3D_EDGE_DATA_STRIDE;\n"
+	s += "\t\tmodel_bsphere_data_offset += 4;\n"
 	s += "\t}\n"
 
 	s += "\n"
 	s += "\t// Common for all objects\n"
 	s += f"\tfor (uint16_t obj_id = 0; obj_id < {scene.name.upper()}_OBJ_COUNT; obj_id++)"+" {\n"
-	s += f"\t\t{scene.name}_objects[obj_id].local_pos = l3d_getZeroVec4();\n"
-	s += f"\t\t{scene.name}_objects[obj_id].orientation = l3d_getIdentityQuat();\n"
+	s += f"\t\tL3D_OBJ_LOCAL_POS({scene_ptr}, obj_id) = l3d_getZeroVec4();\n"
+	s += f"\t\tL3D_OBJ_ORIENTATION({scene_ptr}, obj_id) = l3d_getIdentityQuat();\n"
 	s += f"\t\t// {scene.name}_objects[obj_id].wireframe_colour.value = L3D_COLOUR_WHITE;\n"
-	s += f"\t\t{scene.name}_objects[obj_id].wireframe_colour = L3D_COLOUR_WHITE;\n"
-	# s += f"\t\t// {scene.name}_objects[obj_id].fill_colour.value = L3D_COLOUR_WHITE;\n"
-	# s += f"\t\t{scene.name}_objects[obj_id].fill_colour = L3D_COLOUR_WHITE;	// to be removed\n"
+	s += f"\t\tL3D_OBJ_WIREFRAME_COLOUR({scene_ptr}, obj_id) = L3D_COLOUR_WHITE;\n"
+	s += f"\t\tL3D_OBJ_VISIBLE({scene_ptr}, obj_id) = true;\n"
+	s += f"\t\tL3D_OBJ_FILL_COLOUR({scene_ptr}, obj_id) = L3D_COLOUR_DARKGRAY;\n"
 	s += "\n"
 	s += "\t\t// Local orientation unit vectors\n"
-	s += f"\t\t{scene.name}_objects[obj_id].u[0] = l3d_getVec4FromFloat(0.0f, 0.0f, 0.0f, 1.0f);\n"
-	s += f"\t\t{scene.name}_objects[obj_id].u[1] = l3d_getVec4FromFloat(1.0f, 0.0f, 0.0f, 1.0f);\n"
-	s += f"\t\t{scene.name}_objects[obj_id].u[2] = l3d_getVec4FromFloat(0.0f, 1.0f, 0.0f, 1.0f);\n"
-	s += f"\t\t{scene.name}_objects[obj_id].u[3] = l3d_getVec4FromFloat(0.0f, 0.0f, 1.0f, 1.0f);\n"
+	s += f"\t\tL3D_OBJ_U({scene_ptr}, obj_id)[0] = l3d_getVec4FromFloat(0.0f, 0.0f, 0.0f, 1.0f);\n"
+	s += f"\t\tL3D_OBJ_U({scene_ptr}, obj_id)[1] = l3d_getVec4FromFloat(1.0f, 0.0f, 0.0f, 1.0f);\n"
+	s += f"\t\tL3D_OBJ_U({scene_ptr}, obj_id)[2] = l3d_getVec4FromFloat(0.0f, 1.0f, 0.0f, 1.0f);\n"
+	s += f"\t\tL3D_OBJ_U({scene_ptr}, obj_id)[3] = l3d_getVec4FromFloat(0.0f, 0.0f, 1.0f, 1.0f);\n"
 	s += "\t\t// (parent, children, group, etc) to be added...\n"
 	s += "\t}\n"
 
@@ -687,13 +870,24 @@ def get_scene_init(config, scene) -> str:
 	s += f"\t{scene.name}.model_vert_data = {scene.name}_model_vertex_data;\n"
 	s += f"\t{scene.name}.model_tri_data = {scene.name}_model_face_data;\n"
 	s += f"\t{scene.name}.model_edge_data = {scene.name}_model_edge_data;\n"
+	s += f"\t{scene.name}.model_face_normal_data = {scene.name}_model_face_normal_data;\n"
+	s += f"\t{scene.name}.model_bsphere_data = {scene.name}_model_bsphere_data;\n"
+	if config.getboolean('QuantiseVertices', fallback=False):
+		s += f"\t{scene.name}.model_vert_quant_data = {scene.name}_model_vert_quant_data;\n"
 	s += f"\t\n"
 	s += f"\t{scene.name}.model_vertex_count = {scene.name.upper()}_MODEL_VERT_COUNT;\n"
 	s += f"\t{scene.name}.model_tri_count = {scene.name.upper()}_MODEL_FACE_COUNT;\n"
 	s += f"\t{scene.name}.model_edge_count = {scene.name.upper()}_MODEL_EDGE_COUNT;\n"
 	s += f"\t\n"
+	s += "#ifdef L3D_USE_SOA_VERTICES\n"
+	for coord in ['x', 'y', 'z']:
+		s += f"\t{scene.name}.vertices_world_{coord} = {scene.name}_vertices_world_{coord};\n"
+	for coord in ['x', 'y']:
+		s += f"\t{scene.name}.vertices_screen_{coord} = {scene.name}_vertices_screen_{coord};\n"
+	s += "#else\n"
 	s += f"\t{scene.name}.vertices_world = {scene.name}_vertices_world;\n"
 	s += f"\t{scene.name}.vertices_projected = {scene.name}_vertices_projected;\n"
+	s += "#endif\n"
 	s += f"\t\n"
 	s += f"\t{scene.name}.tri_flags = {scene.name}_face_flags;\n"
 	s += f"\t{scene.name}.edge_flags = {scene.name}_edge_flags;\n"
@@ -702,7 +896,15 @@ def get_scene_init(config, scene) -> str:
 	s += f"\t{scene.name}.tri_flag_count = {scene.name.upper()}_FACE_FLAG_COUNT;\n"
 	s += f"\t{scene.name}.edge_flag_count = {scene.name.upper()}_EDGE_FLAG_COUNT;\n"
 	s += f"\t\n"
+	s += "#ifdef L3D_USE_SOA_OBJECTS\n"
+	for component in ['meshes', 'positions', 'orientations', 'flags', 'gizmos', 'colours']:
+		s += f"\t{scene.name}.object_{component} = {scene.name}_object_{component};\n"
+	s += "#if defined(L3D_USE_DIRTY_RECTANGLES) || defined(REMOVE_HIDDEN_LINES_ANALYTIC)\n"
+	s += f"\t{scene.name}.object_screen_rects = {scene.name}_object_screen_rects;\n"
+	s += "#endif\n"
+	s += "#else\n"
 	s += f"\t{scene.name}.objects = {scene.name}_objects;\n"
+	s += "#endif\n"
 	s += f"\t{scene.name}.object_count = {scene.name.upper()}_OBJ_COUNT;\n"
 	s += f"\t\n"
 
@@ -792,7 +994,22 @@ def get_source_arrays(config, scene) -> str:
 
 	s = ''
 	vertex_array_type = config['VertexArrayType']
-	s += f"const {vertex_array_type} {scene.name}_model_vertex_data[]" + " = {\n"
+	if config.getboolean('UseFixedPoint'):
+		fp_dp = config.getint('FixedPointBinaryDigits')
+		s += f"#if defined(L3D_USE_FIXED_POINT_ARITHMETIC) && L3D_FP_DP != {fp_dp}\n"
+		s += f"#error \"Scene generated with {fp_dp} fractional bits, define L3D_USE_GENERATED_FP_FORMAT in lib3d_config.h\"\n"
+		s += "#endif\n"
+	quantised = config.getboolean('QuantiseVertices', fallback=False)
+	if quantised:
+		s += "#ifndef L3D_USE_QUANTISED_VERTICES\n"
+		s += "#error \"Scene generated with quantised vertices, define L3D_USE_QUANTISED_VERTICES in lib3d_config.h\"\n"
+		s += "#endif\n"
+		s += f"const {config['QuantisedVertexArrayType']} {scene.name}_model_vertex_data[]" + " = {\n"
+	else:
+		s += "#ifdef L3D_USE_QUANTISED_VERTICES\n"
+		s += "#error \"L3D_USE_QUANTISED_VERTICES needs a scene generated with QuantiseVertices = True\"\n"
+		s += "#endif\n"
+		s += f"const {vertex_array_type} {scene.name}_model_vertex_data[]" + " = {\n"
 
 	for mesh in scene.meshes:
 		s += f"\t// {mesh.name}\n"
@@ -834,13 +1051,43 @@ def get_source_arrays(config, scene) -> str:
 			vertex1_id = edge.v1_id #+ vertex_offset
 			vertex2_id = edge.v2_id #+ vertex_offset
 			face_id = edge.face_id #+ faces_offset
-			s += f"{vertex1_id}, {vertex2_id}, {face_id},"
+			face2_id = edge.face2_id #+ faces_offset
+			s += f"{vertex1_id}, {vertex2_id}, {face_id}, {face2_id},"
 			s += '\n'
 		vertex_offset += mesh.vertex_count
 		faces_offset += mesh.face_count
 	s += "};\n"
 	s += '\n'
 
+	s += f"const {vertex_array_type} {scene.name}_model_face_normal_data[]" + " = {\n"
+
+	for mesh in scene.meshes:
+		s += f"\t// {mesh.name}\n"
+		for normal in mesh.face_normal_array:
+			s += '\t'
+			s += f"{get_rational_str(config, normal.x)}, {get_rational_str(config, normal.y)}, {get_rational_str(config, normal.z)},"
+			s += '\n'
+	s += "};\n"
+	s += '\n'
+
+	s += f"const {vertex_array_type} {scene.name}_model_bsphere_data[]" + " = {\n"
+	s += "\t// centre x, centre y, centre z, radius\n"
+
+	for mesh in scene.meshes:
+		s += f"\t// {mesh.name}\n"
+		s += '\t' + ', '.join(str(val) for val in mesh.bounding_sphere) + ',\n'
+	s += "};\n"
+	s += '\n'
+
+	if quantised:
+		s += f"const {config['VertQuantStructType']} {scene.name}_model_vert_quant_data[]" + " = {\n"
+		s += "\t// { offset x, offset y, offset z }, shift\n"
+		for mesh in scene.meshes:
+			s += f"\t// {mesh.name}\n"
+			s += '\t{ { ' + ', '.join(str(val) for val in mesh.vert_quant[:3]) + ' }, ' + str(mesh.vert_quant[3]) + ' },\n'
+		s += "};\n"
+		s += '\n'
+
 	edge_flags_array_type = config['EdgeFlagsArrayType']
 	s += f"{edge_flags_array_type} {scene.name}_edge_flags[]" + " = {\n"
 
@@ -919,6 +1166,9 @@ def main() -> None:
 	parser.add_argument('-i', '--instances', action='store', type=int, nargs='+', help="the number of instances of each model")
 	parser.add_argument('-o', '--output', help="scene name")
 	parser.add_argument('-c', '--cameras', type=int, help="number of cameras in the scene")
+	parser.add_argument('--scene-radius', type=float, default=0.0, help="how far from the origin objects and cameras get placed, for the fixed point format (default: 0)")
+	parser.add_argument('--far-plane', type=float, default=CAMERA_DEFAULT_FAR_PLANE, help="far plane of the cameras, for the fixed point format (default: 1000, L3D_CAMERA_DEFAULT_FAR_PLANE)")
+	parser.add_argument('--screen-size', type=int, nargs=2, default=[800, 400], metavar=('WIDTH', 'HEIGHT'), help="screen size, for the fixed point format (default: 800 400)")
 
 	args = parser.parse_args()
 
@@ -967,19 +1217,40 @@ def main() -> None:
 	else:
 		current_config_section = config['UseFloatingPoint']
 
+	models_lines = [read_lines_from_file(path) for path in models]
+
+	if use_fixed_point:
+		fp_dp, fp_analysis = get_fixed_point_format(models_lines, args.scene_radius, args.far_plane, args.screen_size)
+		if current_config_section['FixedPointBinaryDigits'] == 'auto':
+			current_config_section['FixedPointBinaryDigits'] = str(fp_dp)
+			print(f"FixedPointBinaryDigits = auto: {fp_dp} (Q{32 - fp_dp}.{fp_dp})")
+		elif current_config_section.getint('FixedPointBinaryDigits') > fp_dp:
+			print(f"Warning: FixedPointBinaryDigits = {current_config_section['FixedPointBinaryDigits']} may overflow, {fp_dp} recommended "
+				  "(check with L3D_COUNT_FIXED_POINT_OVERFLOWS)")
+		else:
+			print(f"FixedPointBinaryDigits = {current_config_section['FixedPointBinaryDigits']}, up to {fp_dp} would fit the scene")
+		if CAMERA_DEFAULT_FAR_PLANE >= 1 << (31 - current_config_section.getint('FixedPointBinaryDigits')):
+			print(f"Warning: L3D_CAMERA_DEFAULT_FAR_PLANE ({CAMERA_DEFAULT_FAR_PLANE:g}) does not fit the format, "
+				  f"set the far plane of every camera with l3d_cam_setFarPlane() after l3d_cam_reset()")
+
 	meshes = []
 	mesh_idx = 0
-	for path in models:
+	for path, (vert_lines, face_lines) in zip(models, models_lines):
 		mesh_name = os.path.basename(path).split('.')[0]
-		vert_lines, face_lines = read_lines_from_file(path)
 
 		vert_array_str, vert_array = get_vertex_array(current_config_section, mesh_name, vert_lines)
 		face_array_str, face_array = get_face_array(current_config_section, mesh_name, face_lines)
 		ic(vert_array)
 		ic(face_array)
 		edge_array_str, edge_flags_str, *raw_arrays = get_edge_array(current_config_section, mesh_name, vert_array, face_array)
+		bounding_sphere = get_bounding_sphere(current_config_section, vert_array)
 
-		mesh = Mesh(mesh_name, instances_counts[mesh_idx], vert_array, face_array, edge_array=raw_arrays[0], edge_flags_array=raw_arrays[1])
+		# After the edges, normals and bounding sphere, which need the exact vertices
+		vert_quant = None
+		if current_config_section.getboolean('QuantiseVertices', fallback=False):
+			vert_array, vert_quant = get_quantised_vertex_array(current_config_section, vert_array)
+
+		mesh = Mesh(mesh_name, instances_counts[mesh_idx], vert_array, face_array, edge_array=raw_arrays[0], edge_flags_array=raw_arrays[1], face_normal_array=raw_arrays[2], bounding_sphere=bounding_sphere, vert_quant=vert_quant)
 		meshes.append(mesh)
 		mesh_idx += 1
 
@@ -1002,5 +1273,12 @@ def main() -> None:
 	with output_file.open("w", encoding='utf-8') as f:
 		f.write(source_file_content)
 
+	# Write the header with the fixed point format the data was generated with
+	if use_fixed_point:
+		fp_format_content = get_fp_format_header_content(current_config_section, scene_name, current_config_section.getint('FixedPointBinaryDigits'), fp_analysis)
+		output_file = output_dir / pathlib.Path(FP_FORMAT_HEADER)
+		with output_file.open("w", encoding='utf-8') as f:
+			f.write(fp_format_content)
+
 if __name__ == "__main__":
 	main()
@@ -1,49 +0,0 @@
-#include "cube_tri.h"
-
-const fxp_t mesh_cube_tri_verts[] = {
-	-65536, 65536, 65536,
-	-65536, -65536, 65536,
-	-65536, 65536, -65536,
-	-65536, -65536, -65536,
-	65536, 65536, 65536,
-	65536, -65536, 65536,
-	65536, 65536, -65536,
-	65536, -65536, -65536
-};
-
-const uint16_t mesh_cube_tri_faces[] = {
-	4, 2, 0,
-	2, 7, 3,
-	6, 5, 7,
-	1, 7, 5,
-	0, 3, 1,
-	4, 1, 5,
-	4, 6, 2,
-	2, 6, 7,
-	6, 4, 5,
-	1, 3, 7,
-	0, 2, 3,
-	4, 0, 1
-};
-
-const uint16_t mesh_cube_tri_edges[] = {
-	4, 2, 0, 4,
-	2, 0, 0, 6,
-	4, 0, 0, 6,
-	2, 7, 1, 4,
-	7, 3, 1, 6,
-	2, 3, 1, 6,
-	6, 5, 2, 4,
-	5, 7, 2, 6,
-	6, 7, 2, 6,
-	1, 7, 3, 4,
-	1, 5, 3, 6,
-	0, 3, 4, 4,
-	3, 1, 4, 6,
-	0, 1, 4, 6,
-	4, 1, 5, 4,
-	4, 5, 5, 6,
-	4, 6, 6, 6,
-	6, 2, 6, 6
-};
-
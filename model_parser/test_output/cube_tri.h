@@ -1,18 +0,0 @@
-#ifndef _MESH_CUBE_TRI_H_
-#define _MESH_CUBE_TRI_H_
-
-// 
-// Generated for lib3d by obj file to C array converter by Szymon Kajda.
-// Mesh name: 'cube_tri'
-// Fixed point type: int32_t
-// Fixed point binary digits: 16
-// 
-
-#define MESH_CUBE_TRI_VERT_COUNT 8
-#define MESH_CUBE_TRI_FACE_COUNT 12
-
-extern const rtnl_t mesh_cube_tri_verts[];
-extern const uint16_t mesh_cube_tri_faces[];
-extern const uint16_t mesh_cube_tri_edges[];
-
-#endif // _MESH_CUBE_TRI_H_
@@ -0,0 +1,19 @@
+// 
+// Generated for lib3d by scene descriptor generator by Szymon Kajda.
+// Fixed point format of scene scene_cube, used with L3D_USE_GENERATED_FP_FORMAT
+// 
+// Largest model coordinate: 1, model radius: 1.73205
+// Scene radius (object and camera positions): 0, world range: 1.73205
+// View space range: 3.4641, far plane: 1000
+// Screen: 800x400, projected vertices up to 3200
+// Needed range with x4 headroom: 4000
+// Shortest edge: 2, 1048576 steps of the format
+// Format: Q16.16, values below 32768, resolution 1.52588e-05
+// 
+
+#ifndef _L3D_FP_FORMAT_H_
+#define _L3D_FP_FORMAT_H_
+
+#define L3D_FP_DP 16
+
+#endif // _L3D_FP_FORMAT_H_
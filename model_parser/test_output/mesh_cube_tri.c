@@ -1,70 +0,0 @@
-#include "mesh_cube_tri.h"
-
-const fxp_t mesh_cube_tri_verts[] = {
-	-65536, 65536, 65536,
-	-65536, -65536, 65536,
-	-65536, 65536, -65536,
-	-65536, -65536, -65536,
-	65536, 65536, 65536,
-	65536, -65536, 65536,
-	65536, 65536, -65536,
-	65536, -65536, -65536
-};
-
-const uint16_t mesh_cube_tri_faces[] = {
-	4, 2, 0,
-	2, 7, 3,
-	6, 5, 7,
-	1, 7, 5,
-	0, 3, 1,
-	4, 1, 5,
-	4, 6, 2,
-	2, 6, 7,
-	6, 4, 5,
-	1, 3, 7,
-	0, 2, 3,
-	4, 0, 1
-};
-
-const uint16_t mesh_cube_tri_edges[] = {
-	4, 2, 0,
-	2, 0, 0,
-	4, 0, 0,
-	2, 7, 1,
-	7, 3, 1,
-	2, 3, 1,
-	6, 5, 2,
-	5, 7, 2,
-	6, 7, 2,
-	1, 7, 3,
-	1, 5, 3,
-	0, 3, 4,
-	3, 1, 4,
-	0, 1, 4,
-	4, 1, 5,
-	4, 5, 5,
-	4, 6, 6,
-	6, 2, 6
-};
-
-uint8_t mesh_cube_tri_edge_flags[] = {
-	4,
-	6,
-	6,
-	4,
-	6,
-	6,
-	4,
-	6,
-	6,
-	4,
-	6,
-	4,
-	6,
-	6,
-	4,
-	6,
-	6,
-	6
-};
-
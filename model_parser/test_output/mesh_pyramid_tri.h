@@ -1,20 +0,0 @@
-#ifndef _MESH_PYRAMID_TRI_H_
-#define _MESH_PYRAMID_TRI_H_
-
-// 
-// Generated for lib3d by obj file to C array converter by Szymon Kajda.
-// Mesh name: 'pyramid_tri'
-// Fixed point type: int32_t
-// Fixed point binary digits: 16
-// 
-
-#include "lib3d_config.h"
-
-#define MESH_PYRAMID_TRI_VERT_COUNT 5
-#define MESH_PYRAMID_TRI_FACE_COUNT 6
-
-extern const rtnl_t mesh_pyramid_tri_verts[];
-extern const uint16_t mesh_pyramid_tri_faces[];
-extern const uint16_t mesh_pyramid_tri_edges[];
-
-#endif // _MESH_PYRAMID_TRI_H_
@@ -22,7 +22,7 @@
 // Total number of objects in the scene (different meshes * their no. of instances)
 #define SCENE1_OBJ_COUNT 2
 // Total number of cameras in the scene
-#define SCENE1_CAM_COUNT 2
+#define SCENE1_CAM_COUNT 1
 
 extern l3d_scene_t scene1;
 
@@ -1,7 +1,7 @@
 #include "scene_cube.h"
 #include "lib3d_config.h"
 #include "lib3d_math.h"
-#include "lib3d_core.h // for l3d_setupObjects()"
+#include "lib3d_core.h" // for l3d_setupObjects()
 
 // 
 // Scene defines
@@ -16,6 +16,13 @@
 #define SCENE_CUBE_FACE_FLAG_COUNT 60
 #define SCENE_CUBE_EDGE_FLAG_COUNT 90
 
+// Indices, counts and offsets of the scene have to fit in l3d_index_t
+#if !defined(L3D_USE_32BIT_INDICES) && (SCENE_CUBE_MODEL_VERT_COUNT * 3 > 65535 || SCENE_CUBE_MODEL_FACE_COUNT * 3 > 65535 || \
+	SCENE_CUBE_MODEL_EDGE_COUNT * L3D_EDGE_DATA_STRIDE > 65535 || SCENE_CUBE_TRANSFORMED_VERT_COUNT > 65535 || \
+	SCENE_CUBE_FACE_FLAG_COUNT > 65535 || SCENE_CUBE_EDGE_FLAG_COUNT > 65535)
+#error "Scene too large for 16 bit indices, define L3D_USE_32BIT_INDICES in lib3d_config.h"
+#endif
+
 // 
 // Object defines
 // 
@@ -26,6 +33,12 @@
 #define MESH_PYRAMID_TRI_FACE_COUNT 6
 #define MESH_PYRAMID_TRI_EDGE_COUNT 9
 
+#if defined(L3D_USE_FIXED_POINT_ARITHMETIC) && L3D_FP_DP != 16
+#error "Scene generated with 16 fractional bits, define L3D_USE_GENERATED_FP_FORMAT in lib3d_config.h"
+#endif
+#ifdef L3D_USE_QUANTISED_VERTICES
+#error "L3D_USE_QUANTISED_VERTICES needs a scene generated with QuantiseVertices = True"
+#endif
 const l3d_fxp_t scene_cube_model_vertex_data[] = {
 	// cube_tri
 	-65536, 65536, 65536, 
@@ -44,7 +57,7 @@ const l3d_fxp_t scene_cube_model_vertex_data[] = {
 	-65536, -65536, -65536, 
 };
 
-const uint16_t scene_cube_model_face_data[] = {
+const l3d_index_t scene_cube_model_face_data[] = {
 	// cube_tri
 	4, 2, 0, 
 	2, 7, 3, 
@@ -67,36 +80,67 @@ const uint16_t scene_cube_model_face_data[] = {
 	0, 1, 4, 
 };
 
-const uint16_t scene_cube_model_edge_data[] = {
+const l3d_index_t scene_cube_model_edge_data[] = {
+	// cube_tri
+	4, 2, 0, 6,
+	2, 0, 0, 10,
+	4, 0, 0, 11,
+	2, 7, 1, 7,
+	7, 3, 1, 9,
+	2, 3, 1, 10,
+	6, 5, 2, 8,
+	5, 7, 2, 3,
+	6, 7, 2, 7,
+	1, 7, 3, 9,
+	1, 5, 3, 5,
+	0, 3, 4, 10,
+	3, 1, 4, 9,
+	0, 1, 4, 11,
+	4, 1, 5, 11,
+	4, 5, 5, 8,
+	4, 6, 6, 8,
+	6, 2, 6, 7,
+	// pyramid_tri
+	1, 2, 0, 3,
+	2, 4, 0, 1,
+	1, 4, 0, 5,
+	2, 3, 1, 4,
+	4, 3, 1, 2,
+	0, 4, 2, 5,
+	0, 3, 2, 4,
+	0, 2, 3, 4,
+	0, 1, 3, 5,
+};
+
+const l3d_fxp_t scene_cube_model_face_normal_data[] = {
+	// cube_tri
+	0, 65536, 0,
+	0, 0, -65536,
+	65536, 0, 0,
+	0, -65536, 0,
+	-65536, 0, 0,
+	0, 0, 65536,
+	0, 65536, 0,
+	0, 0, -65536,
+	65536, 0, 0,
+	0, -65536, 0,
+	-65536, 0, 0,
+	0, 0, 65536,
+	// pyramid_tri
+	0, -58617, 29309,
+	-58617, 0, 29309,
+	0, 0, -65536,
+	58617, 0, 29309,
+	0, 58617, 29309,
+	0, 0, -65536,
+};
+
+const l3d_fxp_t scene_cube_model_bsphere_data[] = {
+	// centre x, centre y, centre z, radius
 	// cube_tri
-	4, 2, 0,
-	2, 0, 0,
-	4, 0, 0,
-	2, 7, 1,
-	7, 3, 1,
-	2, 3, 1,
-	6, 5, 2,
-	5, 7, 2,
-	6, 7, 2,
-	1, 7, 3,
-	1, 5, 3,
-	0, 3, 4,
-	3, 1, 4,
-	0, 1, 4,
-	4, 1, 5,
-	4, 5, 5,
-	4, 6, 6,
-	6, 2, 6,
+	0, 0, 0, 113512,
 	// pyramid_tri
-	1, 2, 0,
-	2, 4, 0,
-	1, 4, 0,
-	2, 3, 1,
-	4, 3, 1,
-	0, 4, 2,
-	0, 3, 2,
-	0, 2, 3,
-	0, 1, 3,
+	0, 0, 0, 113512,
 };
 
 uint8_t scene_cube_edge_flags[] = {
@@ -201,10 +245,30 @@ uint8_t scene_cube_edge_flags[] = {
 
 
 l3d_scene_t scene_cube;
+#ifdef L3D_USE_SOA_VERTICES
+l3d_rtnl_t scene_cube_vertices_world_x[SCENE_CUBE_TRANSFORMED_VERT_COUNT];
+l3d_rtnl_t scene_cube_vertices_world_y[SCENE_CUBE_TRANSFORMED_VERT_COUNT];
+l3d_rtnl_t scene_cube_vertices_world_z[SCENE_CUBE_TRANSFORMED_VERT_COUNT];
+int16_t scene_cube_vertices_screen_x[SCENE_CUBE_TRANSFORMED_VERT_COUNT];
+int16_t scene_cube_vertices_screen_y[SCENE_CUBE_TRANSFORMED_VERT_COUNT];
+#else
 l3d_vec4_t scene_cube_vertices_world[SCENE_CUBE_TRANSFORMED_VERT_COUNT];
 l3d_vec4_t scene_cube_vertices_projected[SCENE_CUBE_TRANSFORMED_VERT_COUNT];
+#endif
 uint8_t scene_cube_face_flags[SCENE_CUBE_FACE_FLAG_COUNT];
+#ifdef L3D_USE_SOA_OBJECTS
+l3d_mesh_t scene_cube_object_meshes[SCENE_CUBE_OBJ_COUNT];
+l3d_vec4_t scene_cube_object_positions[SCENE_CUBE_OBJ_COUNT];
+l3d_quat_t scene_cube_object_orientations[SCENE_CUBE_OBJ_COUNT];
+l3d_obj3d_flags_t scene_cube_object_flags[SCENE_CUBE_OBJ_COUNT];
+l3d_obj3d_gizmo_t scene_cube_object_gizmos[SCENE_CUBE_OBJ_COUNT];
+l3d_obj3d_colours_t scene_cube_object_colours[SCENE_CUBE_OBJ_COUNT];
+#if defined(L3D_USE_DIRTY_RECTANGLES) || defined(REMOVE_HIDDEN_LINES_ANALYTIC)
+l3d_rect_t scene_cube_object_screen_rects[SCENE_CUBE_OBJ_COUNT];
+#endif
+#else
 l3d_obj3d_t scene_cube_objects[SCENE_CUBE_OBJ_COUNT];
+#endif
 l3d_scene_instance_desc_t scene_cube_mesh_instances[SCENE_CUBE_MESH_COUNT];
 l3d_camera_t scene_cube_cameras[SCENE_CUBE_CAM_COUNT];
 
@@ -213,62 +277,67 @@ static l3d_err_t init_objects(void) {
 	for (uint16_t i = scene_cube_mesh_instances[0].first_instance_idx;
 		i < scene_cube_mesh_instances[0].first_instance_idx + SCENE_CUBE_OBJ_CUBE_TRI_INSTANCE_COUNT;
 		i++) {
-		scene_cube_objects[i].mesh.vert_count = MESH_CUBE_TRI_VERT_COUNT;
-		scene_cube_objects[i].mesh.tri_count = MESH_CUBE_TRI_FACE_COUNT;
-		scene_cube_objects[i].mesh.edge_count = MESH_CUBE_TRI_EDGE_COUNT;
+		L3D_OBJ_MESH(&scene_cube, i).vert_count = MESH_CUBE_TRI_VERT_COUNT;
+		L3D_OBJ_MESH(&scene_cube, i).tri_count = MESH_CUBE_TRI_FACE_COUNT;
+		L3D_OBJ_MESH(&scene_cube, i).edge_count = MESH_CUBE_TRI_EDGE_COUNT;
 	}
 
 	// pyramid_tri
 	for (uint16_t i = scene_cube_mesh_instances[1].first_instance_idx;
 		i < scene_cube_mesh_instances[1].first_instance_idx + SCENE_CUBE_OBJ_PYRAMID_TRI_INSTANCE_COUNT;
 		i++) {
-		scene_cube_objects[i].mesh.vert_count = MESH_PYRAMID_TRI_VERT_COUNT;
-		scene_cube_objects[i].mesh.tri_count = MESH_PYRAMID_TRI_FACE_COUNT;
-		scene_cube_objects[i].mesh.edge_count = MESH_PYRAMID_TRI_EDGE_COUNT;
+		L3D_OBJ_MESH(&scene_cube, i).vert_count = MESH_PYRAMID_TRI_VERT_COUNT;
+		L3D_OBJ_MESH(&scene_cube, i).tri_count = MESH_PYRAMID_TRI_FACE_COUNT;
+		L3D_OBJ_MESH(&scene_cube, i).edge_count = MESH_PYRAMID_TRI_EDGE_COUNT;
 	}
 
 
-	uint16_t model_vert_data_offset = 0;
-	uint16_t model_tri_data_offset = 0;
-	uint16_t model_edge_data_offset = 0;
-	uint16_t transformed_vertices_offset = 0;
-	uint16_t tris_flags_offset = 0;
-	uint16_t edges_flags_offset = 0;
+	l3d_index_t model_vert_data_offset = 0;
+	l3d_index_t model_tri_data_offset = 0;
+	l3d_index_t model_edge_data_offset = 0;
+	l3d_index_t model_bsphere_data_offset = 0;
+	l3d_index_t transformed_vertices_offset = 0;
+	l3d_index_t tris_flags_offset = 0;
+	l3d_index_t edges_flags_offset = 0;
 
 	for (uint16_t i = 0; i < SCENE_CUBE_MESH_COUNT; i++) {
 		for (uint16_t instance_idx = 0; instance_idx < scene_cube_mesh_instances[i].instance_count; instance_idx++) {
 			uint16_t obj_id = scene_cube_mesh_instances[i].first_instance_idx + instance_idx;
-			scene_cube_objects[obj_id].mesh.model_vert_data_offset = model_vert_data_offset;
-			scene_cube_objects[obj_id].mesh.model_tri_data_offset = model_tri_data_offset;
-			scene_cube_objects[obj_id].mesh.model_edge_data_offset = model_edge_data_offset;
+			L3D_OBJ_MESH(&scene_cube, obj_id).model_vert_data_offset = model_vert_data_offset;
+			L3D_OBJ_MESH(&scene_cube, obj_id).model_tri_data_offset = model_tri_data_offset;
+			L3D_OBJ_MESH(&scene_cube, obj_id).model_edge_data_offset = model_edge_data_offset;
+			L3D_OBJ_MESH(&scene_cube, obj_id).model_bsphere_data_offset = model_bsphere_data_offset;
 
-			scene_cube_objects[obj_id].mesh.transformed_vertices_offset = transformed_vertices_offset;
-			scene_cube_objects[obj_id].mesh.tris_flags_offset = tris_flags_offset;	// not used for now
-			scene_cube_objects[obj_id].mesh.edges_flags_offset = edges_flags_offset;
+			L3D_OBJ_MESH(&scene_cube, obj_id).transformed_vertices_offset = transformed_vertices_offset;
+			L3D_OBJ_MESH(&scene_cube, obj_id).tris_flags_offset = tris_flags_offset;
+			L3D_OBJ_MESH(&scene_cube, obj_id).edges_flags_offset = edges_flags_offset;
 
-			transformed_vertices_offset += scene_cube_objects[obj_id].mesh.vert_count;
-			tris_flags_offset += scene_cube_objects[obj_id].mesh.tri_count;
-			edges_flags_offset += scene_cube_objects[obj_id].mesh.edge_count;
+			transformed_vertices_offset += L3D_OBJ_MESH(&scene_cube, obj_id).vert_count;
+			tris_flags_offset += L3D_OBJ_MESH(&scene_cube, obj_id).tri_count;
+			edges_flags_offset += L3D_OBJ_MESH(&scene_cube, obj_id).edge_count;
 		}
 
 		// Update offsets
-		model_vert_data_offset += scene_cube_objects[scene_cube_mesh_instances[i].first_instance_idx].mesh.vert_count * 3; // check correctness
-		model_tri_data_offset += scene_cube_objects[scene_cube_mesh_instances[i].first_instance_idx].mesh.tri_count * 3; // check correctness
-		model_edge_data_offset += scene_cube_objects[scene_cube_mesh_instances[i].first_instance_idx].mesh.edge_count * 3; // check correctness
+		model_vert_data_offset += L3D_OBJ_MESH(&scene_cube, scene_cube_mesh_instances[i].first_instance_idx).vert_count * 3; // check correctness
+		model_tri_data_offset += L3D_OBJ_MESH(&scene_cube, scene_cube_mesh_instances[i].first_instance_idx).tri_count * 3; // check correctness
+		model_edge_data_offset += L3D_OBJ_MESH(&scene_cube, scene_cube_mesh_instances[i].first_instance_idx).edge_count * L3D_EDGE_DATA_STRIDE;
+		model_bsphere_data_offset += 4;
 	}
 
 	// Common for all objects
 	for (uint16_t obj_id = 0; obj_id < SCENE_CUBE_OBJ_COUNT; obj_id++) {
-		scene_cube_objects[obj_id].local_pos = l3d_getZeroVec4();
-		scene_cube_objects[obj_id].orientation = l3d_getIdentityQuat();
+		L3D_OBJ_LOCAL_POS(&scene_cube, obj_id) = l3d_getZeroVec4();
+		L3D_OBJ_ORIENTATION(&scene_cube, obj_id) = l3d_getIdentityQuat();
 		// scene_cube_objects[obj_id].wireframe_colour.value = L3D_COLOUR_WHITE;
-		scene_cube_objects[obj_id].wireframe_colour = L3D_COLOUR_WHITE;
+		L3D_OBJ_WIREFRAME_COLOUR(&scene_cube, obj_id) = L3D_COLOUR_WHITE;
+		L3D_OBJ_VISIBLE(&scene_cube, obj_id) = true;
+		L3D_OBJ_FILL_COLOUR(&scene_cube, obj_id) = L3D_COLOUR_DARKGRAY;
 
 		// Local orientation unit vectors
-		scene_cube_objects[obj_id].u[0] = l3d_getVec4FromFloat(0.0f, 0.0f, 0.0f, 1.0f);
-		scene_cube_objects[obj_id].u[1] = l3d_getVec4FromFloat(1.0f, 0.0f, 0.0f, 1.0f);
-		scene_cube_objects[obj_id].u[2] = l3d_getVec4FromFloat(0.0f, 1.0f, 0.0f, 1.0f);
-		scene_cube_objects[obj_id].u[3] = l3d_getVec4FromFloat(0.0f, 0.0f, 1.0f, 1.0f);
+		L3D_OBJ_U(&scene_cube, obj_id)[0] = l3d_getVec4FromFloat(0.0f, 0.0f, 0.0f, 1.0f);
+		L3D_OBJ_U(&scene_cube, obj_id)[1] = l3d_getVec4FromFloat(1.0f, 0.0f, 0.0f, 1.0f);
+		L3D_OBJ_U(&scene_cube, obj_id)[2] = l3d_getVec4FromFloat(0.0f, 1.0f, 0.0f, 1.0f);
+		L3D_OBJ_U(&scene_cube, obj_id)[3] = l3d_getVec4FromFloat(0.0f, 0.0f, 1.0f, 1.0f);
 		// (parent, children, group, etc) to be added...
 	}
 
@@ -291,13 +360,23 @@ l3d_err_t scene_cube_init(void) {
 	scene_cube.model_vert_data = scene_cube_model_vertex_data;
 	scene_cube.model_tri_data = scene_cube_model_face_data;
 	scene_cube.model_edge_data = scene_cube_model_edge_data;
+	scene_cube.model_face_normal_data = scene_cube_model_face_normal_data;
+	scene_cube.model_bsphere_data = scene_cube_model_bsphere_data;
 	
 	scene_cube.model_vertex_count = SCENE_CUBE_MODEL_VERT_COUNT;
 	scene_cube.model_tri_count = SCENE_CUBE_MODEL_FACE_COUNT;
 	scene_cube.model_edge_count = SCENE_CUBE_MODEL_EDGE_COUNT;
 	
+#ifdef L3D_USE_SOA_VERTICES
+	scene_cube.vertices_world_x = scene_cube_vertices_world_x;
+	scene_cube.vertices_world_y = scene_cube_vertices_world_y;
+	scene_cube.vertices_world_z = scene_cube_vertices_world_z;
+	scene_cube.vertices_screen_x = scene_cube_vertices_screen_x;
+	scene_cube.vertices_screen_y = scene_cube_vertices_screen_y;
+#else
 	scene_cube.vertices_world = scene_cube_vertices_world;
 	scene_cube.vertices_projected = scene_cube_vertices_projected;
+#endif
 	
 	scene_cube.tri_flags = scene_cube_face_flags;
 	scene_cube.edge_flags = scene_cube_edge_flags;
@@ -306,7 +385,19 @@ l3d_err_t scene_cube_init(void) {
 	scene_cube.tri_flag_count = SCENE_CUBE_FACE_FLAG_COUNT;
 	scene_cube.edge_flag_count = SCENE_CUBE_EDGE_FLAG_COUNT;
 	
+#ifdef L3D_USE_SOA_OBJECTS
+	scene_cube.object_meshes = scene_cube_object_meshes;
+	scene_cube.object_positions = scene_cube_object_positions;
+	scene_cube.object_orientations = scene_cube_object_orientations;
+	scene_cube.object_flags = scene_cube_object_flags;
+	scene_cube.object_gizmos = scene_cube_object_gizmos;
+	scene_cube.object_colours = scene_cube_object_colours;
+#if defined(L3D_USE_DIRTY_RECTANGLES) || defined(REMOVE_HIDDEN_LINES_ANALYTIC)
+	scene_cube.object_screen_rects = scene_cube_object_screen_rects;
+#endif
+#else
 	scene_cube.objects = scene_cube_objects;
+#endif
 	scene_cube.object_count = SCENE_CUBE_OBJ_COUNT;
 	
 	// cube_tri
@@ -319,7 +410,7 @@ l3d_err_t scene_cube_init(void) {
 	scene_cube.cameras = scene_cube_cameras;
 	scene_cube.camera_count = SCENE_CUBE_CAM_COUNT;
 	
-	scene_cube.active_camera = &scene_cube.cameras[0];
+	scene_cube.active_camera_idx = 0;
 	
 	l3d_err_t ret = init_objects();
 
@@ -331,8 +422,8 @@ l3d_err_t scene_cube_init(void) {
 	if (ret != L3D_OK)
 		return ret;
 	
-	l3d_makeProjectionMatrix(&scene_cube.mat_proj, scene_cube.active_camera);
-	l3d_computeViewMatrix(scene_cube.active_camera, &(scene_cube.mat_view));
+	l3d_makeProjectionMatrix(&scene_cube.mat_proj, l3d_scene_getActiveCamera(&scene_cube));
+	l3d_computeViewMatrix(l3d_scene_getActiveCamera(&scene_cube), &(scene_cube.mat_view));
 	return l3d_setupObjects(&scene_cube);
 }
 